@@ -0,0 +1,117 @@
+// NeoPixelBulkWrite
+// This example times the ways of writing a whole frame into the bus buffer,
+// and prints the microseconds per frame for each over serial:
+//
+//   pixel     SetPixelColor() once per pixel
+//   span      SetPixelColors() from a RAM array of colors
+//   span_P    SetPixelColors_P() from a PROGMEM array of colors
+//   render    RenderPixels() with a callback giving each pixel's color,
+//             which also tells how many pixels changed
+//
+// Only the buffer writes are timed, Show() is called once per round so the
+// strip also shows the frames.
+//
+
+#include <NeoPixelBus.h>
+
+const uint16_t PixelCount = 64; // the PROGMEM frame below has this many colors
+const uint8_t PixelPin = 2;  // make sure to set this to the correct pin, ignored for Esp8266
+const uint16_t Rounds = 100;
+
+NeoPixelBus<NeoGrbFeature, Neo800KbpsMethod> strip(PixelCount, PixelPin);
+
+// a dim rainbow, laid out as RgbColor is: R, G, B
+const uint8_t frameProgmem[PixelCount][3] PROGMEM = {
+    { 32, 0, 0 }, { 32, 3, 0 }, { 32, 6, 0 }, { 32, 9, 0 }, { 32, 12, 0 }, { 32, 15, 0 }, { 32, 18, 0 }, { 32, 21, 0 },
+    { 32, 24, 0 }, { 32, 27, 0 }, { 32, 30, 0 }, { 29, 32, 0 }, { 26, 32, 0 }, { 23, 32, 0 }, { 20, 32, 0 }, { 17, 32, 0 },
+    { 14, 32, 0 }, { 11, 32, 0 }, { 8, 32, 0 }, { 5, 32, 0 }, { 2, 32, 0 }, { 0, 32, 1 }, { 0, 32, 4 }, { 0, 32, 7 },
+    { 0, 32, 10 }, { 0, 32, 13 }, { 0, 32, 16 }, { 0, 32, 19 }, { 0, 32, 22 }, { 0, 32, 25 }, { 0, 32, 28 }, { 0, 32, 31 },
+    { 0, 30, 32 }, { 0, 27, 32 }, { 0, 24, 32 }, { 0, 21, 32 }, { 0, 18, 32 }, { 0, 15, 32 }, { 0, 12, 32 }, { 0, 9, 32 },
+    { 0, 6, 32 }, { 0, 3, 32 }, { 0, 0, 32 }, { 3, 0, 32 }, { 6, 0, 32 }, { 9, 0, 32 }, { 12, 0, 32 }, { 15, 0, 32 },
+    { 18, 0, 32 }, { 21, 0, 32 }, { 24, 0, 32 }, { 27, 0, 32 }, { 30, 0, 32 }, { 32, 0, 30 }, { 32, 0, 27 }, { 32, 0, 24 },
+    { 32, 0, 21 }, { 32, 0, 18 }, { 32, 0, 15 }, { 32, 0, 12 }, { 32, 0, 9 }, { 32, 0, 6 }, { 32, 0, 3 }, { 32, 0, 1 },
+};
+
+RgbColor frame[PixelCount];
+uint8_t frameShift = 0;
+
+RgbColor RenderPixel(void* context, uint16_t indexPixel)
+{
+    const RgbColor* colors = static_cast<const RgbColor*>(context);
+
+    return colors[(indexPixel + frameShift) % PixelCount];
+}
+
+void PrintResult(const char* name, uint32_t elapsed)
+{
+    Serial.print(name);
+    Serial.print(" ");
+    Serial.print(elapsed / Rounds);
+    Serial.println(" us per frame");
+}
+
+void setup()
+{
+    Serial.begin(115200);
+    while (!Serial); // wait for serial attach
+
+    strip.Begin();
+    strip.Show();
+
+    for (uint16_t index = 0; index < PixelCount; index++)
+    {
+        memcpy_P(&frame[index], frameProgmem[index], sizeof(RgbColor));
+    }
+}
+
+void loop()
+{
+    uint32_t start;
+    uint32_t changed = 0;
+
+    Serial.print(PixelCount);
+    Serial.println(" pixels");
+
+    start = micros();
+    for (uint16_t round = 0; round < Rounds; round++)
+    {
+        for (uint16_t index = 0; index < PixelCount; index++)
+        {
+            strip.SetPixelColor(index, frame[index]);
+        }
+    }
+    PrintResult("pixel ", micros() - start);
+    strip.Show();
+
+    start = micros();
+    for (uint16_t round = 0; round < Rounds; round++)
+    {
+        strip.SetPixelColors(0, frame, PixelCount);
+    }
+    PrintResult("span  ", micros() - start);
+    strip.Show();
+
+    start = micros();
+    for (uint16_t round = 0; round < Rounds; round++)
+    {
+        strip.SetPixelColors_P(0, frameProgmem, PixelCount);
+    }
+    PrintResult("span_P", micros() - start);
+    strip.Show();
+
+    start = micros();
+    for (uint16_t round = 0; round < Rounds; round++)
+    {
+        // rotate the rainbow each round, so every pixel changes
+        frameShift = round % PixelCount;
+        changed += strip.RenderPixels(0, PixelCount, RenderPixel, frame);
+    }
+    PrintResult("render", micros() - start);
+    Serial.print("render changed ");
+    Serial.print(changed);
+    Serial.println(" pixels");
+    strip.Show();
+
+    Serial.println();
+    delay(2000);
+}
@@ -0,0 +1,114 @@
+// NeoPixelFunFadeInOut16
+// This example will randomly pick a color and fade all pixels to that color, then
+// it will fade them to black and restart over
+// 
+// This example demonstrates NeoPixelAnimator16, the fixed point animator for small
+// chips: the channel count is a template argument, progress is 0 - 65535 rather
+// than a float, and the update function receives a context pointer instead of
+// relying on a global.
+//
+#include <NeoPixelBus.h>
+#include <NeoPixelAnimator16.h>
+
+const uint16_t PixelCount = 16; // make sure to set this to the number of pixels in your strip
+const uint8_t PixelPin = 2;  // make sure to set this to the correct pin, ignored for Esp8266
+const uint8_t AnimationChannels = 1; // we only need one as all the pixels are animated at once
+
+NeoPixelBus<NeoGrbFeature, Neo800KbpsMethod> strip(PixelCount, PixelPin);
+
+NeoPixelAnimator16<AnimationChannels> animations; // NeoPixel animation management object
+
+boolean fadeToColor = true;  // general purpose variable used to store effect state
+
+// what is stored for state is specific to the need, in this case, the colors.
+// it is handed to the update function as its context
+struct MyAnimationState
+{
+    RgbColor StartingColor;
+    RgbColor EndingColor;
+};
+
+MyAnimationState animationState;
+
+// simple blend function
+void BlendAnimUpdate(void* context, const AnimationParam16& param)
+{
+    MyAnimationState* state = static_cast<MyAnimationState*>(context);
+
+    // progress will start at 0 and end at NEO_PROGRESS16_MAX, the top
+    // byte is all the integer blend needs
+    RgbColor updatedColor = RgbColor::LinearBlend8(
+        state->StartingColor,
+        state->EndingColor,
+        (uint8_t)(param.progress >> 8));
+
+    // apply the color to the strip
+    for (uint16_t pixel = 0; pixel < PixelCount; pixel++)
+    {
+        strip.SetPixelColor(pixel, updatedColor);
+    }
+}
+
+void FadeInFadeOutRinseRepeat(uint8_t brightness)
+{
+    animationState.StartingColor = strip.GetPixelColor(0);
+
+    if (fadeToColor)
+    {
+        // Fade upto a random color, one channel full and one random
+        // so they all have similiar overall brightness
+        uint8_t mix = random(brightness);
+        uint16_t time = random(800, 2000);
+
+        switch (random(3))
+        {
+        case 0:
+            animationState.EndingColor = RgbColor(brightness, mix, 0);
+            break;
+        case 1:
+            animationState.EndingColor = RgbColor(0, brightness, mix);
+            break;
+        default:
+            animationState.EndingColor = RgbColor(mix, 0, brightness);
+            break;
+        }
+
+        animations.StartAnimation(0, time, BlendAnimUpdate, &animationState);
+    }
+    else 
+    {
+        // fade to black
+        uint16_t time = random(600, 700);
+
+        animationState.EndingColor = RgbColor(0);
+
+        animations.StartAnimation(0, time, BlendAnimUpdate, &animationState);
+    }
+
+    // toggle to the next effect state
+    fadeToColor = !fadeToColor;
+}
+
+void setup()
+{
+    strip.Begin();
+    strip.Show();
+
+    randomSeed(analogRead(0));
+}
+
+void loop()
+{
+    if (animations.IsAnimating())
+    {
+        // the normal loop just needs these two to run the active animations
+        animations.UpdateAnimations();
+        strip.Show();
+    }
+    else
+    {
+        // no animation runnning, start some 
+        //
+        FadeInFadeOutRinseRepeat(64); // 0 = black, 64 is normal, 128 is bright
+    }
+}
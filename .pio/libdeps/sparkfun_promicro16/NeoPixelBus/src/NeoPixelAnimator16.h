@@ -0,0 +1,387 @@
+/*-------------------------------------------------------------------------
+NeoPixelAnimator16 provides animation timing support without floating point,
+heap allocation or std::function, for small 8 bit targets.
+
+The slot count is a template argument, only running animations are visited
+on update, progress is a 16 bit unit value (0 - 65535 for 0.0 - 1.0) and the
+update callback is a plain function pointer with a context pointer.
+
+-------------------------------------------------------------------------
+This file is part of the Makuna/NeoPixelBus library.
+
+NeoPixelBus is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3 of
+the License, or (at your option) any later version.
+
+NeoPixelBus is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with NeoPixel.  If not, see
+<http://www.gnu.org/licenses/>.
+-------------------------------------------------------------------------*/
+
+#pragma once
+
+#include <Arduino.h>
+#include "NeoPixelAnimator.h"
+
+// progress of 1.0
+#define NEO_PROGRESS16_MAX 0xffff
+
+struct AnimationParam16
+{
+    uint16_t progress; // 0 - NEO_PROGRESS16_MAX
+    uint8_t index;
+    AnimationState state;
+};
+
+typedef void(*AnimUpdateCallback16)(void* context, const AnimationParam16& param);
+
+template <uint8_t V_COUNT_ANIMATIONS> class NeoPixelAnimator16
+{
+public:
+    NeoPixelAnimator16(uint16_t timeScale = NEO_MILLISECONDS) :
+        _animationLastTick(0),
+        _activeAnimations(0),
+        _isRunning(true),
+        _isUpdating(false)
+    {
+        setTimeScale(timeScale);
+
+        for (uint8_t index = 0; index < V_COUNT_ANIMATIONS; index++)
+        {
+            _animations[index]._remaining = 0;
+            _animations[index]._duration = 0;
+            _animations[index]._fnCallback = NULL;
+            _animations[index]._isDeferred = false;
+        }
+    }
+
+    bool IsAnimating() const
+    {
+        return _activeAnimations > 0;
+    }
+
+    bool NextAvailableAnimation(uint8_t* indexAvailable, uint8_t indexStart = 0)
+    {
+        if (indexStart >= V_COUNT_ANIMATIONS)
+        {
+            // last one
+            indexStart = V_COUNT_ANIMATIONS - 1;
+        }
+
+        uint8_t next = indexStart;
+
+        do
+        {
+            if (!IsAnimationActive(next))
+            {
+                if (indexAvailable)
+                {
+                    *indexAvailable = next;
+                }
+                return true;
+            }
+            next = (next + 1) % V_COUNT_ANIMATIONS;
+        } while (next != indexStart);
+        return false;
+    }
+
+    void StartAnimation(uint8_t indexAnimation, uint16_t duration, AnimUpdateCallback16 animUpdate, void* context = NULL)
+    {
+        if (indexAnimation >= V_COUNT_ANIMATIONS || animUpdate == NULL)
+        {
+            return;
+        }
+
+        if (_activeAnimations == 0)
+        {
+            _animationLastTick = millis();
+        }
+
+        StopAnimation(indexAnimation);
+
+        // all animations must have at least non zero duration, otherwise
+        // they are considered stopped
+        if (duration == 0)
+        {
+            duration = 1;
+        }
+
+        _animations[indexAnimation].StartAnimation(duration, animUpdate, context);
+
+        // while updating, a slot stopped this pass is still listed, and one
+        // started this pass waits for the next
+        if (_isUpdating)
+        {
+            _animations[indexAnimation]._isDeferred = true;
+        }
+
+        if (!_isListed(indexAnimation))
+        {
+            _active[_activeAnimations++] = indexAnimation;
+        }
+    }
+
+    void StopAnimation(uint8_t indexAnimation)
+    {
+        if (!IsAnimationActive(indexAnimation))
+        {
+            return;
+        }
+
+        _animations[indexAnimation].StopAnimation();
+
+        // UpdateAnimations() drops it from the list once done walking it
+        if (_isUpdating)
+        {
+            return;
+        }
+
+        // keep the active list in start order
+        for (uint8_t active = 0; active < _activeAnimations; active++)
+        {
+            if (_active[active] == indexAnimation)
+            {
+                _activeAnimations--;
+                memmove(&_active[active], &_active[active + 1], _activeAnimations - active);
+                break;
+            }
+        }
+    }
+
+    void StopAll()
+    {
+        for (uint8_t active = 0; active < _activeAnimations; active++)
+        {
+            _animations[_active[active]].StopAnimation();
+        }
+
+        if (!_isUpdating)
+        {
+            _activeAnimations = 0;
+        }
+    }
+
+    void RestartAnimation(uint8_t indexAnimation)
+    {
+        if (indexAnimation >= V_COUNT_ANIMATIONS || _animations[indexAnimation]._duration == 0)
+        {
+            return;
+        }
+
+        StartAnimation(indexAnimation,
+            _animations[indexAnimation]._duration,
+            _animations[indexAnimation]._fnCallback,
+            _animations[indexAnimation]._context);
+    }
+
+    bool IsAnimationActive(uint8_t indexAnimation) const
+    {
+        if (indexAnimation >= V_COUNT_ANIMATIONS)
+        {
+            return false;
+        }
+        return (_animations[indexAnimation]._remaining != 0);
+    }
+
+    uint16_t AnimationDuration(uint8_t indexAnimation) const
+    {
+        if (indexAnimation >= V_COUNT_ANIMATIONS)
+        {
+            return 0;
+        }
+        return _animations[indexAnimation]._duration;
+    }
+
+    void ChangeAnimationDuration(uint8_t indexAnimation, uint16_t newDuration)
+    {
+        if (indexAnimation >= V_COUNT_ANIMATIONS || newDuration == 0)
+        {
+            return;
+        }
+
+        AnimationContext* pAnim = &_animations[indexAnimation];
+        uint16_t progress = pAnim->CurrentProgress();
+
+        pAnim->SetDuration(newDuration);
+
+        // _remaining must also be reset after a duration change,
+        // use the progress to recalculate it
+        if (pAnim->_remaining != 0)
+        {
+            pAnim->_remaining = newDuration - ((uint32_t)newDuration * progress >> 16);
+        }
+    }
+
+    void UpdateAnimations()
+    {
+        if (!_isRunning || _activeAnimations == 0)
+        {
+            return;
+        }
+
+        uint32_t currentTick = millis();
+        uint32_t delta = currentTick - _animationLastTick;
+
+        if (delta < _timeScale)
+        {
+            return;
+        }
+
+        if (_timeScale > 1)
+        {
+            delta /= _timeScale; // scale delta into animation time
+        }
+
+        // callbacks may start and stop animations, those only mark the slots
+        // and the list is compacted after the walk
+        uint8_t count = _activeAnimations;
+
+        _isUpdating = true;
+
+        for (uint8_t active = 0; active < count; active++)
+        {
+            uint8_t iAnim = _active[active];
+            AnimationContext* pAnim = &_animations[iAnim];
+            AnimationParam16 param;
+
+            if (pAnim->_remaining == 0 || pAnim->_isDeferred)
+            {
+                // stopped or started by a callback this pass
+                continue;
+            }
+
+            param.index = iAnim;
+
+            if (pAnim->_remaining > delta)
+            {
+                param.state = (pAnim->_remaining == pAnim->_duration) ? AnimationState_Started : AnimationState_Progress;
+                param.progress = pAnim->CurrentProgress();
+
+                // before the callback, so a restart from it is kept whole
+                pAnim->_remaining -= delta;
+
+                pAnim->_fnCallback(pAnim->_context, param);
+            }
+            else
+            {
+                param.state = AnimationState_Completed;
+                param.progress = NEO_PROGRESS16_MAX;
+
+                pAnim->StopAnimation();
+
+                pAnim->_fnCallback(pAnim->_context, param);
+            }
+        }
+
+        _isUpdating = false;
+
+        // completed and stopped animations leave the list, the others keep
+        // their order
+        uint8_t kept = 0;
+
+        for (uint8_t active = 0; active < _activeAnimations; active++)
+        {
+            uint8_t iAnim = _active[active];
+
+            _animations[iAnim]._isDeferred = false;
+
+            if (_animations[iAnim]._remaining != 0)
+            {
+                _active[kept++] = iAnim;
+            }
+        }
+        _activeAnimations = kept;
+
+        _animationLastTick = currentTick;
+    }
+
+    bool IsPaused()
+    {
+        return (!_isRunning);
+    }
+
+    void Pause()
+    {
+        _isRunning = false;
+    }
+
+    void Resume()
+    {
+        _isRunning = true;
+        _animationLastTick = millis();
+    }
+
+    uint16_t getTimeScale()
+    {
+        return _timeScale;
+    }
+
+    void setTimeScale(uint16_t timeScale)
+    {
+        _timeScale = (timeScale < 1) ? (1) : (timeScale > 32768) ? 32768 : timeScale;
+    }
+
+private:
+    struct AnimationContext
+    {
+        void StartAnimation(uint16_t duration, AnimUpdateCallback16 animUpdate, void* context)
+        {
+            SetDuration(duration);
+            _remaining = duration;
+            _fnCallback = animUpdate;
+            _context = context;
+        }
+
+        void StopAnimation()
+        {
+            _remaining = 0;
+        }
+
+        void SetDuration(uint16_t duration)
+        {
+            _duration = duration;
+            // the only division, progress is then a multiply
+            _progressStep = 0xffffffff / duration;
+        }
+
+        uint16_t CurrentProgress() const
+        {
+            // elapsed * _progressStep never exceeds 32 bits
+            return ((uint32_t)(_duration - _remaining) * _progressStep) >> 16;
+        }
+
+        uint16_t _duration;
+        uint16_t _remaining;
+        bool _isDeferred; // started during UpdateAnimations(), runs from the next
+        uint32_t _progressStep;
+
+        AnimUpdateCallback16 _fnCallback;
+        void* _context;
+    };
+
+    AnimationContext _animations[V_COUNT_ANIMATIONS];
+    uint8_t _active[V_COUNT_ANIMATIONS];
+    uint32_t _animationLastTick;
+    uint8_t _activeAnimations;
+    uint16_t _timeScale;
+    bool _isRunning;
+    bool _isUpdating;
+
+    bool _isListed(uint8_t indexAnimation) const
+    {
+        for (uint8_t active = 0; active < _activeAnimations; active++)
+        {
+            if (_active[active] == indexAnimation)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+};
@@ -1,5 +1,6 @@
 /*-------------------------------------------------------------------------
 NeoPixelBus library wrapper template class that provides overall brightness control
+and optional gamma correction, applied to the output and not the pixel colors
 
 Written by Michael C. Miller.
 
@@ -28,63 +29,168 @@ License along with NeoPixel.  If not, see
 
 #include "NeoPixelBus.h"
 
-template<typename T_COLOR_FEATURE, typename T_METHOD> class NeoPixelBrightnessBus : 
-    public NeoPixelBus<T_COLOR_FEATURE, T_METHOD>
+// NeoBrightnessMethod wraps a method so that the buffer the bus edits is
+// never changed by brightness or gamma. Update() writes every pixel through
+// a combined brightness and gamma table into the wrapped method's buffer and
+// sends that.
+template<typename T_COLOR_FEATURE, typename T_METHOD, typename T_GAMMA> class NeoBrightnessMethod
 {
-private:
+public:
+    typedef typename T_METHOD::SettingsObject SettingsObject;
+
+    NeoBrightnessMethod(uint8_t pin, uint16_t pixelCount, size_t elementSize, size_t settingsSize) :
+        _output(pin, pixelCount, elementSize, settingsSize),
+        _countPixels(pixelCount)
+    {
+        _construct();
+    }
+
+    NeoBrightnessMethod(uint8_t pin, uint16_t pixelCount, size_t elementSize, size_t settingsSize, NeoBusChannel channel) :
+        _output(pin, pixelCount, elementSize, settingsSize, channel),
+        _countPixels(pixelCount)
+    {
+        _construct();
+    }
+
+    NeoBrightnessMethod(uint8_t pinClock, uint8_t pinData, uint16_t pixelCount, size_t elementSize, size_t settingsSize) :
+        _output(pinClock, pinData, pixelCount, elementSize, settingsSize),
+        _countPixels(pixelCount)
+    {
+        _construct();
+    }
+
+    NeoBrightnessMethod(uint16_t pixelCount, size_t elementSize, size_t settingsSize) :
+        _output(pixelCount, elementSize, settingsSize),
+        _countPixels(pixelCount)
+    {
+        _construct();
+    }
 
-    void ScaleColor(uint16_t scale, typename T_COLOR_FEATURE::ColorObject* color)
+    ~NeoBrightnessMethod()
     {
-        uint8_t* ptr = (uint8_t*)color;
-        uint8_t* ptrEnd = ptr + sizeof(typename T_COLOR_FEATURE::ColorObject);
+        free(_data);
+    }
+
+    bool IsReadyToUpdate() const
+    {
+        return _output.IsReadyToUpdate();
+    }
 
-        while (ptr != ptrEnd)
+    void Initialize()
+    {
+        _output.Initialize();
+    }
+
+    void Initialize(int8_t sck, int8_t miso, int8_t mosi, int8_t ss)
+    {
+        _output.Initialize(sck, miso, mosi, ss);
+    }
+
+    void Initialize(int8_t sck, int8_t dat0, int8_t dat1, int8_t dat2, int8_t dat3, int8_t ss)
+    {
+        _output.Initialize(sck, dat0, dat1, dat2, dat3, ss);
+    }
+
+    void Update(bool maintainBufferConsistency)
+    {
+        size_t sizeData = _output.getDataSize();
+        uint8_t* output = _output.getData();
+        const uint8_t* pixels = T_COLOR_FEATURE::pixels(_data);
+        size_t pixelsStart = pixels - _data;
+        size_t pixelsEnd = pixelsStart + _countPixels * T_COLOR_FEATURE::PixelSize;
+
+        // settings are sent as they are, from before or after the pixels
+        memcpy(output, _data, pixelsStart);
+        memcpy(output + pixelsEnd, _data + pixelsEnd, sizeData - pixelsEnd);
+
+        uint8_t* outputPixels = T_COLOR_FEATURE::pixels(output);
+
+        for (uint16_t indexPixel = 0; indexPixel < _countPixels; indexPixel++)
         {
-            uint16_t value = *ptr;
-            *ptr++ = (value * scale) >> 8;
+            typename T_COLOR_FEATURE::ColorObject color = T_COLOR_FEATURE::retrievePixelColor(pixels, indexPixel);
+            uint8_t* ptr = (uint8_t*)&color;
+            uint8_t* ptrEnd = ptr + sizeof(typename T_COLOR_FEATURE::ColorObject);
+
+            while (ptr != ptrEnd)
+            {
+                *ptr = _table[*ptr];
+                ptr++;
+            }
+
+            T_COLOR_FEATURE::applyPixelColor(outputPixels, indexPixel, color);
         }
+
+        _output.Update(maintainBufferConsistency);
     }
 
-    void ConvertColor(typename T_COLOR_FEATURE::ColorObject* color)
+    uint8_t* getData() const
     {
-        uint16_t scale = _brightness + 1;
-        ScaleColor(scale, color);
+        return _data;
+    };
+
+    size_t getDataSize() const
+    {
+        return _output.getDataSize();
+    };
+
+    void applySettings(const SettingsObject& settings)
+    {
+        _output.applySettings(settings);
     }
 
-    void RecoverColor(typename T_COLOR_FEATURE::ColorObject* color) const
+    void SetBrightness(uint8_t brightness)
     {
-        uint8_t* ptr = (uint8_t*)color;
-        uint8_t* ptrEnd = ptr + sizeof(typename T_COLOR_FEATURE::ColorObject);
-        uint16_t scale = _brightness + 1;
+        uint16_t scale = static_cast<uint16_t>(brightness) + 1;
+        uint8_t value = 0;
 
-        while (ptr != ptrEnd)
+        do
         {
-            uint16_t value = *ptr;
-            *ptr++ = (value << 8) / scale;
-        }
+            _table[value] = (static_cast<uint16_t>(T_GAMMA::Correct(value)) * scale) >> 8;
+        } while (++value != 0);
     }
 
+private:
+    T_METHOD _output;           // the method that sends, its buffer holds what was last sent
+    const uint16_t _countPixels;
+    uint8_t* _data;             // the pixels as they were set, same layout as the output buffer
+    uint8_t _table[256];        // brightness and gamma for each element value
+
+    void _construct()
+    {
+        _data = static_cast<uint8_t*>(malloc(_output.getDataSize()));
+        // data cleared later in Begin()
+
+        SetBrightness(255);
+    }
+};
+
+// Brightness and gamma are applied by Show() on the way out, so setting
+// either costs one 256 entry table and GetPixelColor returns exactly what was
+// set at any brightness. The pixel buffer is twice the size of NeoPixelBus.
+template<typename T_COLOR_FEATURE, typename T_METHOD, typename T_GAMMA = NeoGammaNullMethod> class NeoPixelBrightnessBus : 
+    public NeoPixelBus<T_COLOR_FEATURE, NeoBrightnessMethod<T_COLOR_FEATURE, T_METHOD, T_GAMMA> >
+{
 public:
     NeoPixelBrightnessBus(uint16_t countPixels, uint8_t pin) :
-        NeoPixelBus<T_COLOR_FEATURE, T_METHOD>(countPixels, pin),
+        NeoPixelBus<T_COLOR_FEATURE, NeoBrightnessMethod<T_COLOR_FEATURE, T_METHOD, T_GAMMA> >(countPixels, pin),
         _brightness(255)
     {
     }
     
     NeoPixelBrightnessBus(uint16_t countPixels, uint8_t pin, NeoBusChannel channel) :
-        NeoPixelBus<T_COLOR_FEATURE, T_METHOD>(countPixels, pin, channel),
+        NeoPixelBus<T_COLOR_FEATURE, NeoBrightnessMethod<T_COLOR_FEATURE, T_METHOD, T_GAMMA> >(countPixels, pin, channel),
         _brightness(255)
     {
     }
 
     NeoPixelBrightnessBus(uint16_t countPixels, uint8_t pinClock, uint8_t pinData) :
-        NeoPixelBus<T_COLOR_FEATURE, T_METHOD>(countPixels, pinClock, pinData),
+        NeoPixelBus<T_COLOR_FEATURE, NeoBrightnessMethod<T_COLOR_FEATURE, T_METHOD, T_GAMMA> >(countPixels, pinClock, pinData),
         _brightness(255)
     {
     }
 
     NeoPixelBrightnessBus(uint16_t countPixels) :
-        NeoPixelBus<T_COLOR_FEATURE, T_METHOD>(countPixels),
+        NeoPixelBus<T_COLOR_FEATURE, NeoBrightnessMethod<T_COLOR_FEATURE, T_METHOD, T_GAMMA> >(countPixels),
         _brightness(255)
     {
     }
@@ -94,17 +200,8 @@ public:
         // Only update if there is a change
         if (brightness != _brightness)
         { 
-            uint16_t scale = ((static_cast<uint16_t>(brightness) + 1) << 8) / (static_cast<uint16_t>(_brightness) + 1);
+            this->_method.SetBrightness(brightness);
 
-            // scale existing pixels
-            //
-            for (uint16_t indexPixel = 0; indexPixel < NeoPixelBus<T_COLOR_FEATURE, T_METHOD>::PixelCount(); indexPixel++)
-            {
-                typename T_COLOR_FEATURE::ColorObject color = NeoPixelBus<T_COLOR_FEATURE, T_METHOD>::GetPixelColor(indexPixel);
-                ScaleColor(scale, &color);
-                NeoPixelBus<T_COLOR_FEATURE, T_METHOD>::SetPixelColor(indexPixel, color);
-            }
- 
             _brightness = brightness;
             this->Dirty();
         }
@@ -115,34 +212,6 @@ public:
         return _brightness;
     }
 
-    void SetPixelColor(uint16_t indexPixel, typename T_COLOR_FEATURE::ColorObject color)
-    {
-        ConvertColor(&color);
-        NeoPixelBus<T_COLOR_FEATURE, T_METHOD>::SetPixelColor(indexPixel, color);
-    }
-
-    typename T_COLOR_FEATURE::ColorObject GetPixelColor(uint16_t indexPixel) const
-    {
-        typename T_COLOR_FEATURE::ColorObject color = NeoPixelBus<T_COLOR_FEATURE, T_METHOD>::GetPixelColor(indexPixel);
-        RecoverColor(&color);
-        return color;
-    }
-
-    void ClearTo(typename T_COLOR_FEATURE::ColorObject color)
-    {
-        ConvertColor(&color);
-        NeoPixelBus<T_COLOR_FEATURE, T_METHOD>::ClearTo(color);
-    };
-
-    void ClearTo(typename T_COLOR_FEATURE::ColorObject color, uint16_t first, uint16_t last)
-    {
-        ConvertColor(&color);
-        NeoPixelBus<T_COLOR_FEATURE, T_METHOD>::ClearTo(color, first, last);
-    }
-
-
 protected:
     uint8_t _brightness;
 };
-
-
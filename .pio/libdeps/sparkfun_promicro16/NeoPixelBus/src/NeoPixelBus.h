@@ -86,9 +86,13 @@ License along with NeoPixel.  If not, see
 #include "internal/NeoBitmapFile.h"
 
 #include "internal/NeoEase.h"
+#include "internal/NeoEase16.h"
+#include "internal/NeoEase8.h"
 #include "internal/NeoGamma.h"
 
 #include "internal/NeoBusChannel.h"
+#include "internal/NeoMspimEncoder.h"
+#include "internal/NeoBitPlanes.h"
 
 #include "internal/DotStarGenericMethod.h"
 #include "internal/Lpd8806GenericMethod.h"
@@ -96,7 +100,11 @@ License along with NeoPixel.  If not, see
 #include "internal/Ws2801GenericMethod.h"
 #include "internal/P9813GenericMethod.h"
 
-#if defined(ARDUINO_ARCH_ESP8266)
+#if defined(ARDUINO_HOST_HAL) // emulated Arduino core on a desktop host
+
+#include "internal/NeoHostMethod.h"
+
+#elif defined(ARDUINO_ARCH_ESP8266)
 
 #include "internal/NeoEsp8266DmaMethod.h"
 #include "internal/NeoEsp8266UartMethod.h"
@@ -129,6 +137,9 @@ License along with NeoPixel.  If not, see
 template<typename T_COLOR_FEATURE, typename T_METHOD> class NeoPixelBus
 {
 public:
+    // color of indexPixel for RenderPixels
+    typedef typename T_COLOR_FEATURE::ColorObject(*RenderPixelCallback)(void* context, uint16_t indexPixel);
+
     // Constructor: number of LEDs, pin number
     // NOTE:  Pin Number maybe ignored due to hardware limitations of the method.
    
@@ -251,6 +262,90 @@ public:
         }
     };
 
+    // count colors from first on, clipped to the strip, in one pass over
+    // the buffer
+    void SetPixelColors(uint16_t first, const typename T_COLOR_FEATURE::ColorObject* colors, uint16_t count)
+    {
+        if (first < _countPixels)
+        {
+            uint8_t* pixel = T_COLOR_FEATURE::getPixelAddress(_pixels(), first);
+            const typename T_COLOR_FEATURE::ColorObject* pEnd = colors + _clipCount(first, count);
+
+            while (colors < pEnd)
+            {
+                T_COLOR_FEATURE::applyPixelColor(pixel, 0, *colors++);
+                pixel += T_COLOR_FEATURE::PixelSize;
+            }
+
+            Dirty();
+        }
+    };
+
+    // same as SetPixelColors, with the colors in PROGMEM laid out as
+    // ColorObject is, R, G, B bytes for RgbColor
+    void SetPixelColors_P(uint16_t first, PGM_VOID_P colors, uint16_t count)
+    {
+        if (first < _countPixels)
+        {
+            uint8_t* pixel = T_COLOR_FEATURE::getPixelAddress(_pixels(), first);
+            const uint8_t* pColor = reinterpret_cast<const uint8_t*>(colors);
+            uint8_t* pEnd = pixel + _clipCount(first, count) * T_COLOR_FEATURE::PixelSize;
+
+            while (pixel < pEnd)
+            {
+                typename T_COLOR_FEATURE::ColorObject color;
+
+                memcpy_P(&color, pColor, sizeof(color));
+                pColor += sizeof(color);
+
+                T_COLOR_FEATURE::applyPixelColor(pixel, 0, color);
+                pixel += T_COLOR_FEATURE::PixelSize;
+            }
+
+            Dirty();
+        }
+    };
+
+    // render(context, indexPixel) for count pixels from first on, written
+    // straight into the buffer. Only pixels that change are counted and make
+    // the bus dirty, so a frame that is the same as the last is not sent.
+    uint16_t RenderPixels(uint16_t first, uint16_t count, RenderPixelCallback render, void* context)
+    {
+        uint16_t changed = 0;
+
+        if (first < _countPixels)
+        {
+            uint8_t* pixel = T_COLOR_FEATURE::getPixelAddress(_pixels(), first);
+            uint16_t last = first + _clipCount(first, count);
+
+            for (uint16_t indexPixel = first; indexPixel < last; indexPixel++)
+            {
+                uint8_t temp[T_COLOR_FEATURE::PixelSize];
+                uint8_t diff = 0;
+
+                T_COLOR_FEATURE::applyPixelColor(temp, 0, render(context, indexPixel));
+
+                for (uint8_t iElement = 0; iElement < T_COLOR_FEATURE::PixelSize; iElement++)
+                {
+                    diff |= *pixel ^ temp[iElement];
+                    *pixel++ = temp[iElement];
+                }
+
+                if (diff)
+                {
+                    changed++;
+                }
+            }
+
+            if (changed)
+            {
+                Dirty();
+            }
+        }
+
+        return changed;
+    };
+
     typename T_COLOR_FEATURE::ColorObject GetPixelColor(uint16_t indexPixel) const
     {
         if (indexPixel < _countPixels)
@@ -395,6 +490,12 @@ public:
         _method.applySettings(settings);
         Dirty();
     };
+
+    // for method specific features, like the NeoChunked methods' gap stats
+    T_METHOD& Method()
+    {
+        return _method;
+    };
  
     uint32_t CalcTotalMilliAmpere(const typename T_COLOR_FEATURE::ColorObject::SettingsObject& settings)
     {
@@ -415,6 +516,11 @@ protected:
     uint8_t _state;     // internal state
     T_METHOD _method;
 
+    uint16_t _clipCount(uint16_t first, uint16_t count) const
+    {
+        return (count > _countPixels - first) ? (_countPixels - first) : count;
+    }
+
     uint8_t* _pixels()
     {
         // get pixels data within the data stream
@@ -39,6 +39,7 @@ extern "C"
     void send_data_12mhz_400(uint8_t* data, size_t sizeData, volatile uint8_t* port, uint8_t pinMask);
     void send_data_16mhz_800(uint8_t* data, size_t sizeData, volatile uint8_t* port, uint8_t pinMask);
     void send_data_16mhz_400(uint8_t* data, size_t sizeData, volatile uint8_t* port, uint8_t pinMask);
+    void send_planes_16mhz_800(uint8_t* planes, size_t count, volatile uint8_t* port, uint8_t laneMask);
 }
 
 class NeoAvrSpeed800KbpsBase
@@ -213,6 +214,626 @@ private:
 };
 
 
+#if defined(ARDUINO_ARCH_AVR)
+
+// Timer0 runs at F_CPU / 64 for millis(), rounded up to whole microseconds
+#define NEO_AVR_TIMER0_TICK_US ((64000000UL + F_CPU - 1) / F_CPU)
+
+// counted by the core's Timer0 overflow interrupt, see wiring.c
+extern volatile unsigned long timer0_overflow_count;
+
+// Timer0 ticks with the low byte of the overflow count above them, the way
+// micros() reads them but a few clocks rather than a few microseconds. Wraps
+// every 65536 ticks, 262 ms at 16 MHz. Call with interrupts masked.
+inline uint16_t NeoAvrTimer0Ticks()
+{
+    uint8_t overflows = timer0_overflow_count;
+    uint8_t ticks = TCNT0;
+
+    // overflowed while masked, the interrupt hasn't counted it yet
+    if ((TIFR0 & _BV(TOV0)) && (ticks != 0xff))
+    {
+        overflows++;
+    }
+
+    return (static_cast<uint16_t>(overflows) << 8) | ticks;
+}
+
+// gap from start to now, both NeoAvrTimer0Ticks(), in microseconds. A
+// partial tick either side, so one more than counted.
+inline uint16_t NeoAvrTimer0GapUs(uint16_t start, uint16_t now)
+{
+    uint32_t gapUs = (static_cast<uint32_t>(static_cast<uint16_t>(now - start)) + 1) * NEO_AVR_TIMER0_TICK_US;
+
+    return (gapUs > 0xffff) ? 0xffff : gapUs;
+}
+
+// NeoAvrChunkedMethodBase sends V_CHUNK_PIXELS at a time with interrupts
+// masked and lets pending interrupts run between chunks, so they wait for at
+// most one chunk rather than the whole frame. Every gap is timed on Timer0,
+// overflows included, so a long gap callback can't wrap it; one that may
+// have reached half the reset time could have latched the strip
+// part way, so the frame is then sent again in one masked pass. A gap
+// callback lets the sketch act on what those interrupts brought in before
+// the frame is done.
+template<typename T_SPEED, uint8_t V_CHUNK_PIXELS = 2> class NeoAvrChunkedMethodBase
+{
+public:
+    typedef NeoNoSettings SettingsObject;
+
+    // called between chunks with interrupts enabled
+    typedef void(*GapCallback)(void* context);
+
+    static const uint16_t GapMaxUs = T_SPEED::ResetTimeUs / 2;
+
+    NeoAvrChunkedMethodBase(uint8_t pin, uint16_t pixelCount, size_t elementSize, size_t settingsSize) :
+        _sizeData(pixelCount * elementSize + settingsSize),
+        _sizeChunk(V_CHUNK_PIXELS * elementSize),
+        _pin(pin),
+        _port(NULL),
+        _pinMask(0),
+        _gapCallback(NULL),
+        _gapContext(NULL),
+        _maxGapUs(0),
+        _gapOverruns(0)
+    {
+        pinMode(pin, OUTPUT);
+
+        _data = static_cast<uint8_t*>(malloc(_sizeData));
+        // data cleared later in Begin()
+
+        _port = portOutputRegister(digitalPinToPort(pin));
+        _pinMask = digitalPinToBitMask(pin);
+    }
+
+    ~NeoAvrChunkedMethodBase()
+    {
+        pinMode(_pin, INPUT);
+
+        free(_data);
+    }
+
+    bool IsReadyToUpdate() const
+    {
+        uint32_t delta = micros() - _endTime;
+
+        return (delta >= T_SPEED::ResetTimeUs);
+    }
+
+    void Initialize()
+    {
+        digitalWrite(_pin, LOW);
+
+        _endTime = micros();
+    }
+
+    void Update(bool)
+    {
+        while (!IsReadyToUpdate())
+        {
+#if !defined(ARDUINO_TEEONARDU_LEO) && !defined(ARDUINO_TEEONARDU_FLORA)
+            yield(); // allows for system yield if needed
+#endif
+        }
+
+        if (!_sendChunked())
+        {
+            _gapOverruns++;
+
+            // let the partial frame latch, then send all of it without gaps
+            _endTime = micros();
+
+            while (!IsReadyToUpdate())
+            {
+#if !defined(ARDUINO_TEEONARDU_LEO) && !defined(ARDUINO_TEEONARDU_FLORA)
+                yield();
+#endif
+            }
+
+            noInterrupts();
+
+            T_SPEED::send_data(_data, _sizeData, _port, _pinMask);
+
+            interrupts();
+        }
+
+        // save EOD time for latch on next call
+        _endTime = micros();
+    }
+
+    uint8_t* getData() const
+    {
+        return _data;
+    };
+
+    size_t getDataSize() const
+    {
+        return _sizeData;
+    };
+
+    void applySettings(const SettingsObject& settings)
+    {
+    }
+
+    // longest time the line was held between chunks, rounded up to Timer0 ticks
+    uint16_t MaxGapUs() const
+    {
+        return _maxGapUs;
+    }
+
+    // frames that had to be sent again because a gap reached GapMaxUs
+    uint16_t GapOverruns() const
+    {
+        return _gapOverruns;
+    }
+
+    void ResetGapStats()
+    {
+        _maxGapUs = 0;
+        _gapOverruns = 0;
+    }
+
+    // callback(context) runs in every gap of the frame but the last. Its time
+    // counts toward the gap, so it must return well inside GapMaxUs or the
+    // frame is sent again.
+    void SetGapCallback(GapCallback callback, void* context)
+    {
+        _gapCallback = callback;
+        _gapContext = context;
+    }
+
+private:
+    const size_t  _sizeData;     // size of _data below       
+    const size_t  _sizeChunk;    // bytes sent per masked window
+    const uint8_t _pin;         // output pin number
+
+    uint32_t _endTime;       // Latch timing reference
+    uint8_t* _data;        // Holds data stream which include LED color values and other settings as needed
+    
+    volatile uint8_t* _port;         // Output PORT register
+    uint8_t  _pinMask;      // Output PORT bitmask
+
+    GapCallback _gapCallback;
+    void* _gapContext;
+
+    uint16_t _maxGapUs;
+    uint16_t _gapOverruns;
+
+    bool _sendChunked()
+    {
+        uint8_t* data = _data;
+        size_t remaining = _sizeData;
+        uint16_t gapStart = 0;
+
+        while (remaining)
+        {
+            size_t size = (remaining < _sizeChunk) ? remaining : _sizeChunk;
+
+            noInterrupts();
+
+            if (data != _data)
+            {
+                uint16_t gapUs = NeoAvrTimer0GapUs(gapStart, NeoAvrTimer0Ticks());
+
+                if (gapUs > _maxGapUs)
+                {
+                    _maxGapUs = gapUs;
+                }
+
+                if (gapUs >= GapMaxUs)
+                {
+                    interrupts();
+
+                    return false;
+                }
+            }
+
+            T_SPEED::send_data(data, size, _port, _pinMask);
+
+            gapStart = NeoAvrTimer0Ticks();
+
+            interrupts();
+
+            data += size;
+            remaining -= size;
+
+            if ((_gapCallback) && (remaining))
+            {
+                _gapCallback(_gapContext);
+            }
+        }
+
+        return true;
+    }
+};
+
+#endif
+
+#if defined(ARDUINO_ARCH_AVR) && (F_CPU == 16000000UL)
+
+// NeoAvrParallelMethodBase drives V_LANES strips from one port in a single
+// bit-bang loop, so a frame takes about as long as one lane rather than all
+// of them. The pin is lane 0 and lane n is the pin n port bits above it; the
+// lanes must fit in the port, any beyond bit 7 are dropped. The bus pixels
+// are split over the lanes in order, ceil(pixelCount / V_LANES) to a lane.
+// Each pixel is turned into NeoBitPlanes with interrupts enabled, then sent
+// masked; gaps are timed and overruns resent as in NeoAvrChunkedMethodBase,
+// building the planes counting as part of the gap. That build runs between
+// pixels, about 80 clocks plus 20 a lane per pixel byte, so a frame takes
+// one lane's wire time plus that. A pixel byte is 160 clocks on the wire:
+// x2 sends two in about 280 clocks against 320 one strip after the other,
+// only some 8% faster with the gaps, and barely pays for the second pin. x4
+// and x8 come to about 2x and 3x.
+template<typename T_SPEED, uint8_t V_LANES> class NeoAvrParallelMethodBase
+{
+public:
+    typedef NeoNoSettings SettingsObject;
+
+    static const uint16_t GapMaxUs = T_SPEED::ResetTimeUs / 2;
+
+    NeoAvrParallelMethodBase(uint8_t pin, uint16_t pixelCount, size_t elementSize, size_t settingsSize) :
+        _laneSize(((pixelCount + V_LANES - 1) / V_LANES) * elementSize),
+        _sizeData(_laneSize * V_LANES + settingsSize),
+        _elementSize(elementSize),
+        _pin(pin),
+        _port(NULL),
+        _laneMask(0),
+        _firstBit(0),
+        _lanes(V_LANES),
+        _maxGapUs(0),
+        _gapOverruns(0)
+    {
+        uint8_t pinMask = digitalPinToBitMask(pin);
+
+        while (pinMask >>= 1)
+        {
+            _firstBit++;
+        }
+
+        if (_firstBit + _lanes > 8)
+        {
+            _lanes = 8 - _firstBit;
+        }
+
+        _laneMask = static_cast<uint8_t>(((1 << _lanes) - 1) << _firstBit);
+
+        _port = portOutputRegister(digitalPinToPort(pin));
+        *portModeRegister(digitalPinToPort(pin)) |= _laneMask;
+
+        _data = static_cast<uint8_t*>(malloc(_sizeData));
+        // the tail of the last lane is never set by the bus, keep it dark
+        memset(_data, 0, _sizeData);
+
+        // send_planes_16mhz_800 reads one plane ahead
+        _planes = static_cast<uint8_t*>(malloc(_elementSize * 8 + 1));
+    }
+
+    ~NeoAvrParallelMethodBase()
+    {
+        *portModeRegister(digitalPinToPort(_pin)) &= ~_laneMask;
+
+        free(_planes);
+        free(_data);
+    }
+
+    bool IsReadyToUpdate() const
+    {
+        uint32_t delta = micros() - _endTime;
+
+        return (delta >= T_SPEED::ResetTimeUs);
+    }
+
+    void Initialize()
+    {
+        noInterrupts();
+
+        *_port &= ~_laneMask;
+
+        interrupts();
+
+        _endTime = micros();
+    }
+
+    void Update(bool)
+    {
+        while (!IsReadyToUpdate())
+        {
+#if !defined(ARDUINO_TEEONARDU_LEO) && !defined(ARDUINO_TEEONARDU_FLORA)
+            yield(); // allows for system yield if needed
+#endif
+        }
+
+        if (!_sendPlanes(false))
+        {
+            _gapOverruns++;
+
+            // let the partial frame latch, then send all of it masked,
+            // building the planes being the only gap
+            _endTime = micros();
+
+            while (!IsReadyToUpdate())
+            {
+#if !defined(ARDUINO_TEEONARDU_LEO) && !defined(ARDUINO_TEEONARDU_FLORA)
+                yield();
+#endif
+            }
+
+            _sendPlanes(true);
+        }
+
+        // save EOD time for latch on next call
+        _endTime = micros();
+    }
+
+    uint8_t* getData() const
+    {
+        return _data;
+    };
+
+    size_t getDataSize() const
+    {
+        return _sizeData;
+    };
+
+    void applySettings(const SettingsObject& settings)
+    {
+    }
+
+    // longest time the lanes were held between pixels, rounded up to Timer0 ticks
+    uint16_t MaxGapUs() const
+    {
+        return _maxGapUs;
+    }
+
+    // frames that had to be sent again because a gap reached GapMaxUs
+    uint16_t GapOverruns() const
+    {
+        return _gapOverruns;
+    }
+
+    void ResetGapStats()
+    {
+        _maxGapUs = 0;
+        _gapOverruns = 0;
+    }
+
+private:
+    const size_t  _laneSize;     // bytes per lane
+    const size_t  _sizeData;     // size of _data below       
+    const size_t  _elementSize;  // bytes per pixel, transposed at a time
+    const uint8_t _pin;         // first lane pin number
+
+    uint32_t _endTime;       // Latch timing reference
+    uint8_t* _data;        // Lane after lane of LED color values
+    uint8_t* _planes;      // Bit planes of one pixel of every lane
+
+    volatile uint8_t* _port;         // Output PORT register
+    uint8_t  _laneMask;     // Output PORT bitmask of all lanes
+    uint8_t  _firstBit;     // PORT bit of lane 0
+    uint8_t  _lanes;        // lanes that fit the port
+
+    uint16_t _maxGapUs;
+    uint16_t _gapOverruns;
+
+    bool _sendPlanes(bool masked)
+    {
+        uint16_t gapStart = 0;
+
+        if (masked)
+        {
+            noInterrupts();
+        }
+
+        for (size_t offset = 0; offset < _laneSize; offset += _elementSize)
+        {
+            NeoBitPlanes::FromLanes<V_LANES>(_data, _laneSize, _firstBit, offset, _elementSize, _planes);
+
+            noInterrupts();
+
+            if (offset != 0)
+            {
+                uint16_t gapUs = NeoAvrTimer0GapUs(gapStart, NeoAvrTimer0Ticks());
+
+                if (gapUs > _maxGapUs)
+                {
+                    _maxGapUs = gapUs;
+                }
+
+                if (!masked && gapUs >= GapMaxUs)
+                {
+                    interrupts();
+
+                    return false;
+                }
+            }
+
+            send_planes_16mhz_800(_planes, _elementSize * 8, _port, _laneMask);
+
+            gapStart = NeoAvrTimer0Ticks();
+
+            if (!masked)
+            {
+                interrupts();
+            }
+        }
+
+        interrupts();
+
+        return true;
+    }
+};
+
+#endif
+
+#if defined(ARDUINO_ARCH_AVR) && defined(UCSR1B) && (F_CPU == 16000000UL)
+
+// NeoAvrUsartMspimMethodBase drives the strip from USART1 in SPI master mode
+// with NeoMspimEncoder symbols, so the timing comes from the USART and
+// interrupts stay enabled while the CPU encodes and refills the transmit
+// buffer. The data pin is always TXD1 (PD3, pin 1 on a Pro Micro, pin 18 on a
+// Mega) and XCK1 (PD5) carries the SPI clock, so the pin given is ignored
+// and Serial1 can't be used alongside it.
+//
+// The USART holds one byte in UDR1 and one in the shifter, about 6 us. An
+// interrupt that keeps the CPU away longer starves it mid-bit, which the
+// strip would read as a stretched pulse; that is caught on TXC1 and the frame
+// is sent again once the strip has latched, this time with interrupts masked.
+template<typename T_SPEED> class NeoAvrUsartMspimMethodBase
+{
+public:
+    typedef NeoNoSettings SettingsObject;
+
+    NeoAvrUsartMspimMethodBase(uint8_t pin, uint16_t pixelCount, size_t elementSize, size_t settingsSize) :
+        _sizeData(pixelCount * elementSize + settingsSize),
+        _underruns(0)
+    {
+        _data = static_cast<uint8_t*>(malloc(_sizeData));
+        // data cleared later in Begin()
+    }
+
+    ~NeoAvrUsartMspimMethodBase()
+    {
+        UCSR1B = 0;
+        DDRD &= ~(_BV(PORTD3) | _BV(PORTD5));
+
+        free(_data);
+    }
+
+    bool IsReadyToUpdate() const
+    {
+        uint32_t delta = micros() - _endTime;
+
+        return (delta >= T_SPEED::ResetTimeUs);
+    }
+
+    void Initialize()
+    {
+        // between frames the transmitter is off and the pin is a low output
+        UCSR1B = 0;
+        PORTD &= ~_BV(PORTD3);
+        DDRD |= _BV(PORTD3) | _BV(PORTD5);
+
+        // MSPIM, MSB first, sample on the rising edge
+        UCSR1C = _BV(UMSEL11) | _BV(UMSEL10);
+
+        _endTime = micros();
+    }
+
+    void Update(bool)
+    {
+        while (!IsReadyToUpdate())
+        {
+#if !defined(ARDUINO_TEEONARDU_LEO) && !defined(ARDUINO_TEEONARDU_FLORA)
+            yield(); // allows for system yield if needed
+#endif
+        }
+
+        if (!_send())
+        {
+            _underruns++;
+
+            // let the partial frame latch, then send all of it with nothing in the way
+            _endTime = micros();
+
+            while (!IsReadyToUpdate())
+            {
+#if !defined(ARDUINO_TEEONARDU_LEO) && !defined(ARDUINO_TEEONARDU_FLORA)
+                yield();
+#endif
+            }
+
+            noInterrupts();
+
+            _send();
+
+            interrupts();
+        }
+
+        // save EOD time for latch on next call
+        _endTime = micros();
+    }
+
+    uint8_t* getData() const
+    {
+        return _data;
+    };
+
+    size_t getDataSize() const
+    {
+        return _sizeData;
+    };
+
+    void applySettings(const SettingsObject& settings)
+    {
+    }
+
+    // frames that had to be sent again because the USART ran dry
+    uint16_t Underruns() const
+    {
+        return _underruns;
+    }
+
+    void ResetUnderruns()
+    {
+        _underruns = 0;
+    }
+
+private:
+    const size_t  _sizeData;     // size of _data below       
+
+    uint32_t _endTime;       // Latch timing reference
+    uint8_t* _data;        // Holds data stream which include LED color values and other settings as needed
+
+    uint16_t _underruns;
+
+    bool _send()
+    {
+        const uint8_t* data = _data;
+        const uint8_t* dataEnd = _data + _sizeData;
+        uint8_t symbols[NeoMspimEncoder::SymbolBytesPerByte];
+        bool complete = true;
+
+        // UBRR has to be 0 while the transmitter is enabled, then set before
+        // the first byte; TXC1 is cleared by writing a one
+        UBRR1 = 0;
+        UCSR1A = _BV(TXC1);
+        UCSR1B = _BV(TXEN1);
+        UBRR1 = NeoMspimEncoder::Ubrr16Mhz;
+
+        while (data != dataEnd)
+        {
+            NeoMspimEncoder::EncodeByte(*data++, symbols);
+
+            for (uint8_t symbol = 0; symbol < NeoMspimEncoder::SymbolBytesPerByte; symbol++)
+            {
+                while (!(UCSR1A & _BV(UDRE1)))
+                {
+                }
+
+                UDR1 = symbols[symbol];
+            }
+
+            // TXC1 only sets if the shifter emptied with nothing waiting
+            if (UCSR1A & _BV(TXC1))
+            {
+                complete = false;
+                break;
+            }
+        }
+
+        while (!(UCSR1A & _BV(TXC1)))
+        {
+        }
+
+        // hand the pin back to PORTD, low
+        UCSR1B = 0;
+
+        return complete;
+    }
+};
+
+#endif
+
 typedef NeoAvrMethodBase<NeoAvrSpeedWs2812x> NeoAvrWs2812xMethod;
 typedef NeoAvrMethodBase<NeoAvrSpeedSk6812> NeoAvrSk6812Method;
 typedef NeoAvrMethodBase<NeoAvrSpeedTm1814> NeoAvrTm1814InvertedMethod;
@@ -232,6 +853,41 @@ typedef NeoAvr400KbpsMethod NeoApa106Method;
 typedef NeoAvrWs2812xMethod Neo800KbpsMethod;
 typedef NeoAvr400KbpsMethod Neo400KbpsMethod;
 
+#if defined(ARDUINO_ARCH_AVR)
+typedef NeoAvrChunkedMethodBase<NeoAvrSpeedWs2812x> NeoAvrChunkedWs2812xMethod;
+typedef NeoAvrChunkedMethodBase<NeoAvrSpeedSk6812> NeoAvrChunkedSk6812Method;
+typedef NeoAvrChunkedMethodBase<NeoAvrSpeed800Kbps> NeoAvrChunked800KbpsMethod;
+
+typedef NeoAvrChunkedWs2812xMethod NeoChunkedWs2812xMethod;
+typedef NeoAvrChunkedSk6812Method NeoChunkedSk6812Method;
+typedef NeoAvrChunkedWs2812xMethod NeoChunked800KbpsMethod;
+#endif
+
+#if defined(ARDUINO_ARCH_AVR) && (F_CPU == 16000000UL)
+// a transposed pixel of gap is well inside half the WS2812x and SK6812
+// reset times, but not that of the original WS2812. X2 is barely faster than
+// two strips driven one after the other, see NeoAvrParallelMethodBase.
+typedef NeoAvrParallelMethodBase<NeoAvrSpeedWs2812x, 2> NeoAvrX2Ws2812xMethod;
+typedef NeoAvrParallelMethodBase<NeoAvrSpeedWs2812x, 4> NeoAvrX4Ws2812xMethod;
+typedef NeoAvrParallelMethodBase<NeoAvrSpeedWs2812x, 8> NeoAvrX8Ws2812xMethod;
+typedef NeoAvrParallelMethodBase<NeoAvrSpeedSk6812, 2> NeoAvrX2Sk6812Method;
+typedef NeoAvrParallelMethodBase<NeoAvrSpeedSk6812, 4> NeoAvrX4Sk6812Method;
+typedef NeoAvrParallelMethodBase<NeoAvrSpeedSk6812, 8> NeoAvrX8Sk6812Method;
+
+typedef NeoAvrX2Ws2812xMethod NeoX2Ws2812xMethod;
+typedef NeoAvrX4Ws2812xMethod NeoX4Ws2812xMethod;
+typedef NeoAvrX8Ws2812xMethod NeoX8Ws2812xMethod;
+typedef NeoAvrX2Sk6812Method NeoX2Sk6812Method;
+typedef NeoAvrX4Sk6812Method NeoX4Sk6812Method;
+typedef NeoAvrX8Sk6812Method NeoX8Sk6812Method;
+#endif
+
+#if defined(ARDUINO_ARCH_AVR) && defined(UCSR1B) && (F_CPU == 16000000UL)
+// the 375 ns one-low of NeoMspimEncoder is within WS2812B/WS2813 limits
+// only, the original WS2812 and the SK6812 want 450 ns or more
+typedef NeoAvrUsartMspimMethodBase<NeoAvrSpeedWs2812x> NeoAvrUsartWs2812xMethod;
+#endif
+
 // there is no non-invert methods for avr, but the norm for TM1814 is inverted, so
 typedef NeoAvrTm1814InvertedMethod NeoTm1814InvertedMethod;
 typedef NeoAvrTm1914InvertedMethod NeoTm1914InvertedMethod;
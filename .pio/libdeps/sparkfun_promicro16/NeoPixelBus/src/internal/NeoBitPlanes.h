@@ -0,0 +1,183 @@
+/*-------------------------------------------------------------------------
+NeoBitPlanes transposes pixel data of up to 8 strips into bit planes, one
+byte per WS2812 bit period holding that bit of every strip at its port bit,
+so a single loop can clock all of them out of one port together.
+
+It has no hardware dependencies so it can be checked on a host.
+
+-------------------------------------------------------------------------
+This file is part of the Makuna/NeoPixelBus library.
+
+NeoPixelBus is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3 of
+the License, or (at your option) any later version.
+
+NeoPixelBus is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with NeoPixel.  If not, see
+<http://www.gnu.org/licenses/>.
+-------------------------------------------------------------------------*/
+
+#pragma once
+
+class NeoBitPlanes
+{
+public:
+    // In place 8 x 8 bit transpose: on entry rows[7 - n] is the byte for
+    // port bit n, on return rows[0] holds every row's most significant bit
+    // and rows[7] the least, each at its port bit. The transpose is its own
+    // inverse.
+    static void Transpose8(uint8_t* rows)
+    {
+        uint8_t t;
+
+        // swap 4 x 4 blocks, then 2 x 2, then single bits
+        for (uint8_t i = 0; i < 4; i++)
+        {
+            t = (rows[i] ^ (rows[i + 4] >> 4)) & 0x0f;
+            rows[i] ^= t;
+            rows[i + 4] ^= t << 4;
+        }
+
+        for (uint8_t i = 0; i < 8; i += (i & 1) ? 3 : 1)
+        {
+            t = (rows[i] ^ (rows[i + 2] >> 2)) & 0x33;
+            rows[i] ^= t;
+            rows[i + 2] ^= t << 2;
+        }
+
+        for (uint8_t i = 0; i < 8; i += 2)
+        {
+            t = (rows[i] ^ (rows[i + 1] >> 1)) & 0x55;
+            rows[i] ^= t;
+            rows[i + 1] ^= t << 1;
+        }
+    }
+
+    // Planes for count bytes from offset in each lane, 8 planes per byte.
+    // Lane n starts at data + n * laneSize and goes out on port bit
+    // firstBit + n; firstBit + laneCount must not be over 8.
+    static void FromLanes(const uint8_t* data, size_t laneSize, uint8_t laneCount, uint8_t firstBit,
+        size_t offset, size_t count, uint8_t* planes)
+    {
+        for (size_t index = 0; index < count; index++)
+        {
+            uint8_t* rows = planes + index * 8;
+            const uint8_t* src = data + offset + index;
+
+            memset(rows, 0, 8);
+
+            for (uint8_t lane = 0; lane < laneCount; lane++)
+            {
+                rows[7 - firstBit - lane] = *src;
+                src += laneSize;
+            }
+
+            Transpose8(rows);
+        }
+    }
+
+    // FromLanes for V_LANES lanes, its cost following the lanes: each plane
+    // is shifted together from the top bit of every lane, about 20 clocks a
+    // lane and 80 more per byte on AVR, where the 8 x 8 transpose and
+    // clearing of unused rows is about 260 whatever the lanes. Lanes past
+    // port bit 7 are dropped.
+    template<uint8_t V_LANES> static void FromLanes(const uint8_t* data, size_t laneSize, uint8_t firstBit,
+        size_t offset, size_t count, uint8_t* planes)
+    {
+        const uint8_t portBit = 1 << firstBit;
+
+        for (size_t index = 0; index < count; index++)
+        {
+            const uint8_t* src = data + offset + index;
+            uint8_t lane0 = src[0];
+            uint8_t lane1 = (V_LANES > 1) ? src[laneSize] : 0;
+            uint8_t lane2 = (V_LANES > 2) ? src[laneSize * 2] : 0;
+            uint8_t lane3 = (V_LANES > 3) ? src[laneSize * 3] : 0;
+            uint8_t lane4 = (V_LANES > 4) ? src[laneSize * 4] : 0;
+            uint8_t lane5 = (V_LANES > 5) ? src[laneSize * 5] : 0;
+            uint8_t lane6 = (V_LANES > 6) ? src[laneSize * 6] : 0;
+            uint8_t lane7 = (V_LANES > 7) ? src[laneSize * 7] : 0;
+
+            for (uint8_t plane = 0; plane < 8; plane++)
+            {
+                uint8_t bits = 0;
+
+                // the last lane first, so lane 0 ends on the lowest bit
+                if (V_LANES > 7)
+                {
+                    _shiftIn(bits, lane7);
+                }
+                if (V_LANES > 6)
+                {
+                    _shiftIn(bits, lane6);
+                }
+                if (V_LANES > 5)
+                {
+                    _shiftIn(bits, lane5);
+                }
+                if (V_LANES > 4)
+                {
+                    _shiftIn(bits, lane4);
+                }
+                if (V_LANES > 3)
+                {
+                    _shiftIn(bits, lane3);
+                }
+                if (V_LANES > 2)
+                {
+                    _shiftIn(bits, lane2);
+                }
+                if (V_LANES > 1)
+                {
+                    _shiftIn(bits, lane1);
+                }
+                _shiftIn(bits, lane0);
+
+                // lanes moved past port bit 7 fall off the top
+                *planes++ = bits * portBit;
+            }
+        }
+    }
+
+    // The reverse of FromLanes
+    static void ToLanes(const uint8_t* planes, size_t laneSize, uint8_t laneCount, uint8_t firstBit,
+        size_t offset, size_t count, uint8_t* data)
+    {
+        for (size_t index = 0; index < count; index++)
+        {
+            uint8_t rows[8];
+            uint8_t* dest = data + offset + index;
+
+            memcpy(rows, planes + index * 8, 8);
+
+            Transpose8(rows);
+
+            for (uint8_t lane = 0; lane < laneCount; lane++)
+            {
+                *dest = rows[7 - firstBit - lane];
+                dest += laneSize;
+            }
+        }
+    }
+
+private:
+    // the top bit of lane is shifted in at the bottom of bits
+    static void _shiftIn(uint8_t& bits, uint8_t& lane)
+    {
+#if defined(__AVR__)
+        // lsl leaves the top bit in carry and rol takes it, 2 clocks
+        asm("lsl %1" "\n\t"
+            "rol %0"
+            : "+r" (bits), "+r" (lane));
+#else
+        bits = (bits << 1) | (lane >> 7);
+        lane <<= 1;
+#endif
+    }
+};
@@ -76,7 +76,7 @@ public:
         unitValue *= 2.0f;
         if (unitValue < 1.0f)
         {
-            return (-0.5f * (unitValue * unitValue - 2.0f));
+            return (-0.5f * unitValue * (unitValue - 2.0f));
         }
         else
         {
@@ -211,7 +211,7 @@ public:
         }
         else
         {
-            return (-0.5f * (cos(PI * (unitValue-0.5f)) + 1.0f));
+            return (-0.5f * (cos(PI * (unitValue-0.5f)) - 2.0f));
         }
         
     }
@@ -295,14 +295,9 @@ public:
         {
             return (0.5f * sqrt(1.0f - unitValue * unitValue));
         }
-        else if (unitValue > 0.0f)
-        {
-            unitValue -= 2.0f;
-            return (-0.5f * (sqrt(1.0f - unitValue * unitValue) - 1.0f ) + 0.5f);
-        }
         else
         {
-            return 1.0f;
+            return (-0.5f * (sqrt(1.0f - unitValue * unitValue) - 1.0f ) + 0.5f);
         }
     }
 
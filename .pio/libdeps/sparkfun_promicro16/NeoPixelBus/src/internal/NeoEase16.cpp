@@ -0,0 +1,102 @@
+/*-------------------------------------------------------------------------
+NeoEase16 tables for the curves that are not polynomials, sampled at
+i / 256 for i = 0 - 256 and scaled to 0 - 65535.
+
+-------------------------------------------------------------------------
+This file is part of the Makuna/NeoPixelBus library.
+
+NeoPixelBus is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3 of
+the License, or (at your option) any later version.
+
+NeoPixelBus is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with NeoPixel.  If not, see
+<http://www.gnu.org/licenses/>.
+-------------------------------------------------------------------------*/
+
+#include <Arduino.h>
+#include "NeoPixelBus.h"
+
+// sin(x * PI / 2), SinusoidalOut
+const uint16_t NeoEase16::_sineTable[257] PROGMEM = {
+        0,   402,   804,  1206,  1608,  2010,  2412,  2814,  3216,  3617,  4019,  4420,
+     4821,  5222,  5623,  6023,  6424,  6824,  7223,  7623,  8022,  8421,  8820,  9218,
+     9616, 10014, 10411, 10808, 11204, 11600, 11996, 12391, 12785, 13179, 13573, 13966,
+    14359, 14751, 15142, 15533, 15924, 16313, 16703, 17091, 17479, 17866, 18253, 18639,
+    19024, 19408, 19792, 20175, 20557, 20939, 21319, 21699, 22078, 22456, 22834, 23210,
+    23586, 23960, 24334, 24707, 25079, 25450, 25820, 26189, 26557, 26925, 27291, 27656,
+    28020, 28383, 28745, 29106, 29465, 29824, 30181, 30538, 30893, 31247, 31600, 31952,
+    32302, 32651, 32999, 33346, 33692, 34036, 34379, 34721, 35061, 35400, 35738, 36074,
+    36409, 36743, 37075, 37406, 37736, 38064, 38390, 38715, 39039, 39361, 39682, 40001,
+    40319, 40635, 40950, 41263, 41575, 41885, 42194, 42500, 42806, 43109, 43411, 43712,
+    44011, 44308, 44603, 44897, 45189, 45479, 45768, 46055, 46340, 46624, 46905, 47185,
+    47464, 47740, 48014, 48287, 48558, 48827, 49095, 49360, 49624, 49885, 50145, 50403,
+    50659, 50913, 51166, 51416, 51664, 51911, 52155, 52398, 52638, 52877, 53113, 53348,
+    53580, 53811, 54039, 54266, 54490, 54713, 54933, 55151, 55367, 55582, 55794, 56003,
+    56211, 56417, 56620, 56822, 57021, 57218, 57413, 57606, 57797, 57985, 58171, 58356,
+    58537, 58717, 58895, 59070, 59243, 59414, 59582, 59749, 59913, 60075, 60234, 60391,
+    60546, 60699, 60850, 60998, 61144, 61287, 61429, 61567, 61704, 61838, 61970, 62100,
+    62227, 62352, 62475, 62595, 62713, 62829, 62942, 63053, 63161, 63267, 63371, 63472,
+    63571, 63668, 63762, 63853, 63943, 64030, 64114, 64196, 64276, 64353, 64428, 64500,
+    64570, 64638, 64703, 64765, 64826, 64883, 64939, 64992, 65042, 65090, 65136, 65179,
+    65219, 65258, 65293, 65327, 65357, 65386, 65412, 65435, 65456, 65475, 65491, 65504,
+    65515, 65524, 65530, 65534, 65535
+};
+
+// 2 ^ (10 * (x - 1)), ExponentialIn
+const uint16_t NeoEase16::_exponentialTable[257] PROGMEM = {
+       64,    66,    68,    69,    71,    73,    75,    77,    79,    82,    84,    86,
+       89,    91,    93,    96,    99,   101,   104,   107,   110,   113,   116,   119,
+      123,   126,   129,   133,   137,   140,   144,   148,   152,   156,   161,   165,
+      170,   174,   179,   184,   189,   194,   200,   205,   211,   216,   222,   228,
+      235,   241,   248,   255,   262,   269,   276,   284,   292,   300,   308,   316,
+      325,   334,   343,   352,   362,   372,   382,   393,   403,   415,   426,   438,
+      450,   462,   475,   488,   501,   515,   529,   543,   558,   574,   589,   606,
+      622,   639,   657,   675,   693,   712,   732,   752,   773,   794,   816,   838,
+      861,   885,   909,   934,   960,   986,  1013,  1041,  1069,  1099,  1129,  1160,
+     1192,  1224,  1258,  1292,  1328,  1364,  1402,  1440,  1480,  1520,  1562,  1605,
+     1649,  1694,  1741,  1789,  1838,  1888,  1940,  1993,  2048,  2104,  2162,  2221,
+     2282,  2345,  2409,  2475,  2543,  2613,  2685,  2758,  2834,  2912,  2992,  3074,
+     3158,  3245,  3334,  3426,  3520,  3616,  3716,  3818,  3922,  4030,  4141,  4254,
+     4371,  4491,  4614,  4741,  4871,  5005,  5142,  5283,  5428,  5577,  5730,  5887,
+     6049,  6215,  6386,  6561,  6741,  6926,  7116,  7311,  7512,  7718,  7930,  8148,
+     8371,  8601,  8837,  9080,  9329,  9585,  9848, 10118, 10396, 10681, 10974, 11276,
+    11585, 11903, 12230, 12565, 12910, 13265, 13629, 14003, 14387, 14782, 15188, 15604,
+    16033, 16473, 16925, 17389, 17867, 18357, 18861, 19378, 19910, 20457, 21018, 21595,
+    22188, 22797, 23422, 24065, 24726, 25404, 26102, 26818, 27554, 28310, 29087, 29886,
+    30706, 31549, 32415, 33304, 34218, 35157, 36122, 37114, 38132, 39179, 40254, 41359,
+    42494, 43660, 44859, 46090, 47355, 48655, 49990, 51362, 52772, 54220, 55708, 57237,
+    58808, 60422, 62081, 63784, 65535
+};
+
+// x ^ (1 / 0.45), Gamma
+const uint16_t NeoEase16::_gammaTable[257] PROGMEM = {
+        0,     0,     1,     3,     6,    10,    16,    22,    30,    38,    49,    60,
+       73,    87,   103,   120,   138,   158,   180,   203,   227,   253,   281,   310,
+      340,   373,   407,   442,   479,   518,   559,   601,   645,   691,   738,   787,
+      838,   891,   945,  1001,  1059,  1119,  1180,  1244,  1309,  1376,  1445,  1516,
+     1588,  1663,  1739,  1817,  1897,  1979,  2063,  2149,  2237,  2327,  2419,  2512,
+     2608,  2705,  2805,  2906,  3010,  3115,  3223,  3333,  3444,  3558,  3673,  3791,
+     3911,  4032,  4156,  4282,  4410,  4540,  4672,  4806,  4942,  5081,  5221,  5363,
+     5508,  5655,  5804,  5955,  6108,  6263,  6421,  6580,  6742,  6906,  7072,  7241,
+     7411,  7584,  7758,  7935,  8115,  8296,  8480,  8666,  8854,  9044,  9237,  9431,
+     9628,  9828, 10029, 10233, 10439, 10647, 10857, 11070, 11285, 11503, 11722, 11944,
+    12168, 12395, 12624, 12855, 13088, 13324, 13562, 13802, 14045, 14290, 14537, 14787,
+    15039, 15293, 15550, 15809, 16070, 16334, 16600, 16869, 17140, 17413, 17689, 17967,
+    18247, 18530, 18815, 19102, 19392, 19685, 19980, 20277, 20576, 20878, 21183, 21490,
+    21799, 22111, 22425, 22742, 23061, 23382, 23706, 24033, 24362, 24693, 25027, 25363,
+    25702, 26043, 26387, 26733, 27081, 27432, 27786, 28142, 28501, 28862, 29226, 29592,
+    29960, 30331, 30705, 31081, 31460, 31841, 32225, 32611, 33000, 33391, 33785, 34182,
+    34581, 34982, 35386, 35793, 36202, 36614, 37028, 37445, 37864, 38286, 38711, 39138,
+    39568, 40000, 40435, 40872, 41312, 41755, 42200, 42648, 43099, 43552, 44007, 44466,
+    44927, 45390, 45856, 46325, 46796, 47270, 47747, 48226, 48708, 49193, 49680, 50170,
+    50662, 51157, 51655, 52155, 52659, 53164, 53673, 54184, 54697, 55214, 55733, 56255,
+    56779, 57306, 57836, 58368, 58903, 59441, 59982, 60525, 61071, 61619, 62171, 62724,
+    63281, 63841, 64403, 64967, 65535
+};
@@ -0,0 +1,351 @@
+/*-------------------------------------------------------------------------
+NeoEase16 provides the NeoEase animation curves on fixed point unit values,
+0 - 65535 for 0.0 - 1.0, without floating point.
+
+Polynomial curves are integer multiplies; the sinusoidal, exponential and
+gamma curves interpolate a 257 entry PROGMEM table; circular curves use an
+integer square root.
+
+-------------------------------------------------------------------------
+This file is part of the Makuna/NeoPixelBus library.
+
+NeoPixelBus is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3 of
+the License, or (at your option) any later version.
+
+NeoPixelBus is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with NeoPixel.  If not, see
+<http://www.gnu.org/licenses/>.
+-------------------------------------------------------------------------*/
+
+#pragma once
+
+typedef uint16_t(*AnimEaseFunction16)(uint16_t unitValue);
+
+class NeoEase16
+{
+public:
+    static uint16_t Linear(uint16_t unitValue)
+    {
+        return unitValue;
+    }
+
+    static uint16_t QuadraticIn(uint16_t unitValue)
+    {
+        return _mul(unitValue, unitValue);
+    }
+
+    static uint16_t QuadraticOut(uint16_t unitValue)
+    {
+        return ~QuadraticIn(~unitValue);
+    }
+
+    static uint16_t QuadraticInOut(uint16_t unitValue)
+    {
+        if (unitValue < 0x8000)
+        {
+            return QuadraticIn(_lowerHalf(unitValue)) >> 1;
+        }
+        else
+        {
+            return 0x8000 + (QuadraticOut(_upperHalf(unitValue)) >> 1);
+        }
+    }
+
+    static uint16_t QuadraticCenter(uint16_t unitValue)
+    {
+        if (unitValue < 0x8000)
+        {
+            return QuadraticOut(_lowerHalf(unitValue)) >> 1;
+        }
+        else
+        {
+            return 0x8000 + (QuadraticIn(_upperHalf(unitValue)) >> 1);
+        }
+    }
+
+    static uint16_t CubicIn(uint16_t unitValue)
+    {
+        return _mul(_mul(unitValue, unitValue), unitValue);
+    }
+
+    static uint16_t CubicOut(uint16_t unitValue)
+    {
+        return ~CubicIn(~unitValue);
+    }
+
+    static uint16_t CubicInOut(uint16_t unitValue)
+    {
+        if (unitValue < 0x8000)
+        {
+            return CubicIn(_lowerHalf(unitValue)) >> 1;
+        }
+        else
+        {
+            return 0x8000 + (CubicOut(_upperHalf(unitValue)) >> 1);
+        }
+    }
+
+    static uint16_t CubicCenter(uint16_t unitValue)
+    {
+        if (unitValue < 0x8000)
+        {
+            return CubicOut(_lowerHalf(unitValue)) >> 1;
+        }
+        else
+        {
+            return 0x8000 + (CubicIn(_upperHalf(unitValue)) >> 1);
+        }
+    }
+
+    static uint16_t QuarticIn(uint16_t unitValue)
+    {
+        return _square(_square(unitValue));
+    }
+
+    static uint16_t QuarticOut(uint16_t unitValue)
+    {
+        return ~QuarticIn(~unitValue);
+    }
+
+    static uint16_t QuarticInOut(uint16_t unitValue)
+    {
+        if (unitValue < 0x8000)
+        {
+            return QuarticIn(_lowerHalf(unitValue)) >> 1;
+        }
+        else
+        {
+            return 0x8000 + (QuarticOut(_upperHalf(unitValue)) >> 1);
+        }
+    }
+
+    static uint16_t QuarticCenter(uint16_t unitValue)
+    {
+        if (unitValue < 0x8000)
+        {
+            return QuarticOut(_lowerHalf(unitValue)) >> 1;
+        }
+        else
+        {
+            return 0x8000 + (QuarticIn(_upperHalf(unitValue)) >> 1);
+        }
+    }
+
+    static uint16_t QuinticIn(uint16_t unitValue)
+    {
+        return _mul(_square(_square(unitValue)), unitValue);
+    }
+
+    static uint16_t QuinticOut(uint16_t unitValue)
+    {
+        return ~QuinticIn(~unitValue);
+    }
+
+    static uint16_t QuinticInOut(uint16_t unitValue)
+    {
+        if (unitValue < 0x8000)
+        {
+            return QuinticIn(_lowerHalf(unitValue)) >> 1;
+        }
+        else
+        {
+            return 0x8000 + (QuinticOut(_upperHalf(unitValue)) >> 1);
+        }
+    }
+
+    static uint16_t QuinticCenter(uint16_t unitValue)
+    {
+        if (unitValue < 0x8000)
+        {
+            return QuinticOut(_lowerHalf(unitValue)) >> 1;
+        }
+        else
+        {
+            return 0x8000 + (QuinticIn(_upperHalf(unitValue)) >> 1);
+        }
+    }
+
+    static uint16_t SinusoidalIn(uint16_t unitValue)
+    {
+        return ~SinusoidalOut(~unitValue);
+    }
+
+    static uint16_t SinusoidalOut(uint16_t unitValue)
+    {
+        return _lookup(_sineTable, unitValue);
+    }
+
+    static uint16_t SinusoidalInOut(uint16_t unitValue)
+    {
+        if (unitValue < 0x8000)
+        {
+            return SinusoidalIn(_lowerHalf(unitValue)) >> 1;
+        }
+        else
+        {
+            return 0x8000 + (SinusoidalOut(_upperHalf(unitValue)) >> 1);
+        }
+    }
+
+    static uint16_t SinusoidalCenter(uint16_t unitValue)
+    {
+        if (unitValue < 0x8000)
+        {
+            return SinusoidalOut(_lowerHalf(unitValue)) >> 1;
+        }
+        else
+        {
+            return 0x8000 + (SinusoidalIn(_upperHalf(unitValue)) >> 1);
+        }
+    }
+
+    static uint16_t ExponentialIn(uint16_t unitValue)
+    {
+        return _lookup(_exponentialTable, unitValue);
+    }
+
+    static uint16_t ExponentialOut(uint16_t unitValue)
+    {
+        return ~ExponentialIn(~unitValue);
+    }
+
+    static uint16_t ExponentialInOut(uint16_t unitValue)
+    {
+        if (unitValue < 0x8000)
+        {
+            return ExponentialIn(_lowerHalf(unitValue)) >> 1;
+        }
+        else
+        {
+            return 0x8000 + (ExponentialOut(_upperHalf(unitValue)) >> 1);
+        }
+    }
+
+    static uint16_t ExponentialCenter(uint16_t unitValue)
+    {
+        if (unitValue < 0x8000)
+        {
+            return ExponentialOut(_lowerHalf(unitValue)) >> 1;
+        }
+        else
+        {
+            return 0x8000 + (ExponentialIn(_upperHalf(unitValue)) >> 1);
+        }
+    }
+
+    static uint16_t CircularIn(uint16_t unitValue)
+    {
+        return ~CircularOut(~unitValue);
+    }
+
+    static uint16_t CircularOut(uint16_t unitValue)
+    {
+        // sqrt(1 - (1 - x)^2)
+        uint16_t complement = ~unitValue;
+
+        return _sqrt(0xfffe0001UL - (uint32_t)complement * complement);
+    }
+
+    static uint16_t CircularInOut(uint16_t unitValue)
+    {
+        if (unitValue < 0x8000)
+        {
+            return CircularIn(_lowerHalf(unitValue)) >> 1;
+        }
+        else
+        {
+            return 0x8000 + (CircularOut(_upperHalf(unitValue)) >> 1);
+        }
+    }
+
+    static uint16_t CircularCenter(uint16_t unitValue)
+    {
+        if (unitValue < 0x8000)
+        {
+            return CircularOut(_lowerHalf(unitValue)) >> 1;
+        }
+        else
+        {
+            return 0x8000 + (CircularIn(_upperHalf(unitValue)) >> 1);
+        }
+    }
+
+    static uint16_t Gamma(uint16_t unitValue)
+    {
+        return _lookup(_gammaTable, unitValue);
+    }
+
+private:
+    static const uint16_t _sineTable[257];
+    static const uint16_t _exponentialTable[257];
+    static const uint16_t _gammaTable[257];
+
+    // rounded unit multiply, exact at 0 and 65535
+    static uint16_t _mul(uint16_t left, uint16_t right)
+    {
+        return ((uint32_t)left * right + left + 0x8000) >> 16;
+    }
+
+    static uint16_t _square(uint16_t unitValue)
+    {
+        return _mul(unitValue, unitValue);
+    }
+
+    // the first and second half of the range stretched over the whole range
+    static uint16_t _lowerHalf(uint16_t unitValue)
+    {
+        return unitValue << 1;
+    }
+
+    static uint16_t _upperHalf(uint16_t unitValue)
+    {
+        return (unitValue << 1) + 1;
+    }
+
+    // linear interpolation between the table entries either side, the
+    // fraction weight reaches 256 so 65535 lands exactly on the last entry
+    static uint16_t _lookup(const uint16_t* table, uint16_t unitValue)
+    {
+        uint8_t index = unitValue >> 8;
+        uint8_t fraction = unitValue;
+        uint16_t weight = fraction + (fraction >> 7);
+        uint16_t left = pgm_read_word(table + index);
+        uint16_t right = pgm_read_word(table + index + 1);
+
+        return left + (((uint32_t)(right - left) * weight) >> 8);
+    }
+
+    static uint16_t _sqrt(uint32_t value)
+    {
+        uint32_t root = 0;
+        uint32_t bit = 1UL << 30;
+
+        while (bit > value)
+        {
+            bit >>= 2;
+        }
+
+        while (bit != 0)
+        {
+            if (value >= root + bit)
+            {
+                value -= root + bit;
+                root = (root >> 1) + bit;
+            }
+            else
+            {
+                root >>= 1;
+            }
+            bit >>= 2;
+        }
+
+        return root;
+    }
+};
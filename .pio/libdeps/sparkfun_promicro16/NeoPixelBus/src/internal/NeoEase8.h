@@ -0,0 +1,345 @@
+/*-------------------------------------------------------------------------
+NeoEase8 provides the NeoEase animation curves on fixed point unit values,
+0 - 255 for 0.0 - 1.0, without floating point.
+
+Polynomial curves are 8 bit multiplies; the others are taken from NeoEase16
+at the same unit value.
+
+-------------------------------------------------------------------------
+This file is part of the Makuna/NeoPixelBus library.
+
+NeoPixelBus is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3 of
+the License, or (at your option) any later version.
+
+NeoPixelBus is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with NeoPixel.  If not, see
+<http://www.gnu.org/licenses/>.
+-------------------------------------------------------------------------*/
+
+#pragma once
+
+typedef uint8_t(*AnimEaseFunction8)(uint8_t unitValue);
+
+class NeoEase8
+{
+public:
+    static uint8_t Linear(uint8_t unitValue)
+    {
+        return unitValue;
+    }
+
+    static uint8_t QuadraticIn(uint8_t unitValue)
+    {
+        return _mul(unitValue, unitValue);
+    }
+
+    static uint8_t QuadraticOut(uint8_t unitValue)
+    {
+        return ~QuadraticIn(~unitValue);
+    }
+
+    static uint8_t QuadraticInOut(uint8_t unitValue)
+    {
+        if (unitValue < 0x80)
+        {
+            return QuadraticIn(_lowerHalf(unitValue)) >> 1;
+        }
+        else
+        {
+            return 0x80 + (QuadraticOut(_upperHalf(unitValue)) >> 1);
+        }
+    }
+
+    static uint8_t QuadraticCenter(uint8_t unitValue)
+    {
+        if (unitValue < 0x80)
+        {
+            return QuadraticOut(_lowerHalf(unitValue)) >> 1;
+        }
+        else
+        {
+            return 0x80 + (QuadraticIn(_upperHalf(unitValue)) >> 1);
+        }
+    }
+
+    static uint8_t CubicIn(uint8_t unitValue)
+    {
+        return _mul(_mul(unitValue, unitValue), unitValue);
+    }
+
+    static uint8_t CubicOut(uint8_t unitValue)
+    {
+        return ~CubicIn(~unitValue);
+    }
+
+    static uint8_t CubicInOut(uint8_t unitValue)
+    {
+        if (unitValue < 0x80)
+        {
+            return CubicIn(_lowerHalf(unitValue)) >> 1;
+        }
+        else
+        {
+            return 0x80 + (CubicOut(_upperHalf(unitValue)) >> 1);
+        }
+    }
+
+    static uint8_t CubicCenter(uint8_t unitValue)
+    {
+        if (unitValue < 0x80)
+        {
+            return CubicOut(_lowerHalf(unitValue)) >> 1;
+        }
+        else
+        {
+            return 0x80 + (CubicIn(_upperHalf(unitValue)) >> 1);
+        }
+    }
+
+    static uint8_t QuarticIn(uint8_t unitValue)
+    {
+        return _square(_square(unitValue));
+    }
+
+    static uint8_t QuarticOut(uint8_t unitValue)
+    {
+        return ~QuarticIn(~unitValue);
+    }
+
+    static uint8_t QuarticInOut(uint8_t unitValue)
+    {
+        if (unitValue < 0x80)
+        {
+            return QuarticIn(_lowerHalf(unitValue)) >> 1;
+        }
+        else
+        {
+            return 0x80 + (QuarticOut(_upperHalf(unitValue)) >> 1);
+        }
+    }
+
+    static uint8_t QuarticCenter(uint8_t unitValue)
+    {
+        if (unitValue < 0x80)
+        {
+            return QuarticOut(_lowerHalf(unitValue)) >> 1;
+        }
+        else
+        {
+            return 0x80 + (QuarticIn(_upperHalf(unitValue)) >> 1);
+        }
+    }
+
+    static uint8_t QuinticIn(uint8_t unitValue)
+    {
+        return _mul(_square(_square(unitValue)), unitValue);
+    }
+
+    static uint8_t QuinticOut(uint8_t unitValue)
+    {
+        return ~QuinticIn(~unitValue);
+    }
+
+    static uint8_t QuinticInOut(uint8_t unitValue)
+    {
+        if (unitValue < 0x80)
+        {
+            return QuinticIn(_lowerHalf(unitValue)) >> 1;
+        }
+        else
+        {
+            return 0x80 + (QuinticOut(_upperHalf(unitValue)) >> 1);
+        }
+    }
+
+    static uint8_t QuinticCenter(uint8_t unitValue)
+    {
+        if (unitValue < 0x80)
+        {
+            return QuinticOut(_lowerHalf(unitValue)) >> 1;
+        }
+        else
+        {
+            return 0x80 + (QuinticIn(_upperHalf(unitValue)) >> 1);
+        }
+    }
+
+    static uint8_t SinusoidalIn(uint8_t unitValue)
+    {
+        return _from16(NeoEase16::SinusoidalIn(_to16(unitValue)));
+    }
+
+    static uint8_t SinusoidalOut(uint8_t unitValue)
+    {
+        return _from16(NeoEase16::SinusoidalOut(_to16(unitValue)));
+    }
+
+    static uint8_t SinusoidalInOut(uint8_t unitValue)
+    {
+        if (unitValue < 0x80)
+        {
+            return SinusoidalIn(_lowerHalf(unitValue)) >> 1;
+        }
+        else
+        {
+            return 0x80 + (SinusoidalOut(_upperHalf(unitValue)) >> 1);
+        }
+    }
+
+    static uint8_t SinusoidalCenter(uint8_t unitValue)
+    {
+        if (unitValue < 0x80)
+        {
+            return SinusoidalOut(_lowerHalf(unitValue)) >> 1;
+        }
+        else
+        {
+            return 0x80 + (SinusoidalIn(_upperHalf(unitValue)) >> 1);
+        }
+    }
+
+    static uint8_t ExponentialIn(uint8_t unitValue)
+    {
+        return _from16(NeoEase16::ExponentialIn(_to16(unitValue)));
+    }
+
+    static uint8_t ExponentialOut(uint8_t unitValue)
+    {
+        return _from16(NeoEase16::ExponentialOut(_to16(unitValue)));
+    }
+
+    static uint8_t ExponentialInOut(uint8_t unitValue)
+    {
+        if (unitValue < 0x80)
+        {
+            return ExponentialIn(_lowerHalf(unitValue)) >> 1;
+        }
+        else
+        {
+            return 0x80 + (ExponentialOut(_upperHalf(unitValue)) >> 1);
+        }
+    }
+
+    static uint8_t ExponentialCenter(uint8_t unitValue)
+    {
+        if (unitValue < 0x80)
+        {
+            return ExponentialOut(_lowerHalf(unitValue)) >> 1;
+        }
+        else
+        {
+            return 0x80 + (ExponentialIn(_upperHalf(unitValue)) >> 1);
+        }
+    }
+
+    static uint8_t CircularIn(uint8_t unitValue)
+    {
+        return ~CircularOut(~unitValue);
+    }
+
+    static uint8_t CircularOut(uint8_t unitValue)
+    {
+        // sqrt(1 - (1 - x)^2)
+        uint8_t complement = ~unitValue;
+
+        return _sqrt(65025 - (uint16_t)complement * complement);
+    }
+
+    static uint8_t CircularInOut(uint8_t unitValue)
+    {
+        if (unitValue < 0x80)
+        {
+            return CircularIn(_lowerHalf(unitValue)) >> 1;
+        }
+        else
+        {
+            return 0x80 + (CircularOut(_upperHalf(unitValue)) >> 1);
+        }
+    }
+
+    static uint8_t CircularCenter(uint8_t unitValue)
+    {
+        if (unitValue < 0x80)
+        {
+            return CircularOut(_lowerHalf(unitValue)) >> 1;
+        }
+        else
+        {
+            return 0x80 + (CircularIn(_upperHalf(unitValue)) >> 1);
+        }
+    }
+
+    static uint8_t Gamma(uint8_t unitValue)
+    {
+        return _from16(NeoEase16::Gamma(_to16(unitValue)));
+    }
+
+private:
+    // rounded unit multiply, exact at 0 and 255
+    static uint8_t _mul(uint8_t left, uint8_t right)
+    {
+        return ((uint16_t)left * right + left + 0x80) >> 8;
+    }
+
+    static uint8_t _square(uint8_t unitValue)
+    {
+        return _mul(unitValue, unitValue);
+    }
+
+    // the first and second half of the range stretched over the whole range
+    static uint8_t _lowerHalf(uint8_t unitValue)
+    {
+        return unitValue << 1;
+    }
+
+    static uint8_t _upperHalf(uint8_t unitValue)
+    {
+        return (unitValue << 1) + 1;
+    }
+
+    // x * 257 is the same unit value in 16 bits
+    static uint16_t _to16(uint8_t unitValue)
+    {
+        return ((uint16_t)unitValue << 8) | unitValue;
+    }
+
+    // rounded divide by 257
+    static uint8_t _from16(uint16_t unitValue)
+    {
+        return (unitValue - (unitValue >> 8) + 0x80) >> 8;
+    }
+
+    static uint8_t _sqrt(uint16_t value)
+    {
+        uint16_t root = 0;
+        uint16_t bit = 1U << 14;
+
+        while (bit > value)
+        {
+            bit >>= 2;
+        }
+
+        while (bit != 0)
+        {
+            if (value >= root + bit)
+            {
+                value -= root + bit;
+                root = (root >> 1) + bit;
+            }
+            else
+            {
+                root >>= 1;
+            }
+            bit >>= 2;
+        }
+
+        return root;
+    }
+};
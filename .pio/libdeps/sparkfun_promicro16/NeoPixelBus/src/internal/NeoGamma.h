@@ -36,6 +36,16 @@ public:
     }
 };
 
+// NeoGammaNullMethod leaves values as they are
+class NeoGammaNullMethod
+{
+public:
+    static uint8_t Correct(uint8_t value)
+    {
+        return value;
+    }
+};
+
 // NeoGammaTableMethod uses 256 bytes of memory, but is significantly faster
 class NeoGammaTableMethod
 {
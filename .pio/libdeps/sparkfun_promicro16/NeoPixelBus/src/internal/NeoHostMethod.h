@@ -0,0 +1,572 @@
+/*-------------------------------------------------------------------------
+NeoPixel library helper functions for host (emulated Arduino HAL) builds.
+
+The method does not drive any pin. It charges the virtual clock the time the
+frame would occupy on the wire, with interrupts disabled as the AVR bit-bang
+methods do, and hands every transmitted frame to the HAL for capture.
+
+-------------------------------------------------------------------------
+This file is part of the Makuna/NeoPixelBus library.
+
+NeoPixelBus is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3 of
+the License, or (at your option) any later version.
+
+NeoPixelBus is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with NeoPixel.  If not, see
+<http://www.gnu.org/licenses/>.
+-------------------------------------------------------------------------*/
+
+#pragma once
+
+#if defined(ARDUINO_HOST_HAL)
+
+class NeoHostSpeed800KbpsBase
+{
+public:
+    // 1.25us per bit
+    static uint32_t FrameTimeUs(size_t sizeData)
+    {
+        return (sizeData * 8 * 5 + 3) / 4;
+    }
+};
+
+class NeoHostSpeedWs2812x : public NeoHostSpeed800KbpsBase
+{
+public:
+    static const uint32_t ResetTimeUs = 300;
+};
+
+class NeoHostSpeedSk6812 : public NeoHostSpeed800KbpsBase
+{
+public:
+    static const uint32_t ResetTimeUs = 80;
+};
+
+class NeoHostSpeedTm1814 : public NeoHostSpeed800KbpsBase
+{
+public:
+    static const uint32_t ResetTimeUs = 200;
+};
+
+class NeoHostSpeedTm1829 : public NeoHostSpeed800KbpsBase
+{
+public:
+    static const uint32_t ResetTimeUs = 200;
+};
+
+class NeoHostSpeed800Kbps : public NeoHostSpeed800KbpsBase
+{
+public:
+    static const uint32_t ResetTimeUs = 50;
+};
+
+class NeoHostSpeed400Kbps
+{
+public:
+    // 2.5us per bit
+    static uint32_t FrameTimeUs(size_t sizeData)
+    {
+        return (sizeData * 8 * 5 + 1) / 2;
+    }
+    static const uint32_t ResetTimeUs = 50;
+};
+
+template<typename T_SPEED> class NeoHostMethodBase
+{
+public:
+    typedef NeoNoSettings SettingsObject;
+
+    NeoHostMethodBase(uint8_t pin, uint16_t pixelCount, size_t elementSize, size_t settingsSize) :
+        _sizeData(pixelCount * elementSize + settingsSize),
+        _pin(pin),
+        _endTime(0)
+    {
+        pinMode(pin, OUTPUT);
+
+        _data = static_cast<uint8_t*>(malloc(_sizeData));
+        // data cleared later in Begin()
+    }
+
+    ~NeoHostMethodBase()
+    {
+        pinMode(_pin, INPUT);
+
+        free(_data);
+    }
+
+    bool IsReadyToUpdate() const
+    {
+        uint32_t delta = micros() - _endTime;
+
+        return (delta >= T_SPEED::ResetTimeUs);
+    }
+
+    void Initialize()
+    {
+        digitalWrite(_pin, LOW);
+
+        _endTime = micros();
+    }
+
+    void Update(bool)
+    {
+        while (!IsReadyToUpdate())
+        {
+            yield();
+        }
+
+        uint32_t start = micros();
+
+        noInterrupts(); // matches the bit-bang methods' masked window
+
+        delayMicroseconds(T_SPEED::FrameTimeUs(_sizeData));
+
+        interrupts();
+
+        // save EOD time for latch on next call
+        _endTime = micros();
+
+        halLedShow(_data, _sizeData, start, _endTime);
+    }
+
+    uint8_t* getData() const
+    {
+        return _data;
+    };
+
+    size_t getDataSize() const
+    {
+        return _sizeData;
+    };
+
+    void applySettings(const SettingsObject& settings)
+    {
+    }
+
+private:
+    const size_t  _sizeData;    // size of _data below
+    const uint8_t _pin;         // output pin number
+
+    uint32_t _endTime;          // Latch timing reference
+    uint8_t* _data;             // Holds data stream which include LED color values and other settings as needed
+};
+
+// Same chunking and gap check as NeoAvrChunkedMethodBase, with gaps timed on
+// the virtual clock. Interrupts that came due while a chunk was sent are
+// delivered in the gap after it, ahead of the gap callback.
+template<typename T_SPEED, uint8_t V_CHUNK_PIXELS = 2> class NeoHostChunkedMethodBase
+{
+public:
+    typedef NeoNoSettings SettingsObject;
+
+    typedef void(*GapCallback)(void* context);
+
+    static const uint16_t GapMaxUs = T_SPEED::ResetTimeUs / 2;
+
+    NeoHostChunkedMethodBase(uint8_t pin, uint16_t pixelCount, size_t elementSize, size_t settingsSize) :
+        _sizeData(pixelCount * elementSize + settingsSize),
+        _sizeChunk(V_CHUNK_PIXELS * elementSize),
+        _pin(pin),
+        _endTime(0),
+        _gapCallback(NULL),
+        _gapContext(NULL),
+        _maxGapUs(0),
+        _gapOverruns(0)
+    {
+        pinMode(pin, OUTPUT);
+
+        _data = static_cast<uint8_t*>(malloc(_sizeData));
+        // data cleared later in Begin()
+    }
+
+    ~NeoHostChunkedMethodBase()
+    {
+        pinMode(_pin, INPUT);
+
+        free(_data);
+    }
+
+    bool IsReadyToUpdate() const
+    {
+        uint32_t delta = micros() - _endTime;
+
+        return (delta >= T_SPEED::ResetTimeUs);
+    }
+
+    void Initialize()
+    {
+        digitalWrite(_pin, LOW);
+
+        _endTime = micros();
+    }
+
+    void Update(bool)
+    {
+        while (!IsReadyToUpdate())
+        {
+            yield();
+        }
+
+        uint32_t start = micros();
+
+        if (!_sendChunked())
+        {
+            _gapOverruns++;
+
+            // let the partial frame latch, then send all of it without gaps
+            _endTime = micros();
+
+            while (!IsReadyToUpdate())
+            {
+                yield();
+            }
+
+            start = micros();
+
+            noInterrupts();
+
+            delayMicroseconds(T_SPEED::FrameTimeUs(_sizeData));
+
+            interrupts();
+        }
+
+        // save EOD time for latch on next call
+        _endTime = micros();
+
+        halLedShow(_data, _sizeData, start, _endTime);
+    }
+
+    uint8_t* getData() const
+    {
+        return _data;
+    };
+
+    size_t getDataSize() const
+    {
+        return _sizeData;
+    };
+
+    void applySettings(const SettingsObject& settings)
+    {
+    }
+
+    uint16_t MaxGapUs() const
+    {
+        return _maxGapUs;
+    }
+
+    uint16_t GapOverruns() const
+    {
+        return _gapOverruns;
+    }
+
+    void ResetGapStats()
+    {
+        _maxGapUs = 0;
+        _gapOverruns = 0;
+    }
+
+    void SetGapCallback(GapCallback callback, void* context)
+    {
+        _gapCallback = callback;
+        _gapContext = context;
+    }
+
+private:
+    const size_t  _sizeData;    // size of _data below
+    const size_t  _sizeChunk;   // bytes sent per masked window
+    const uint8_t _pin;         // output pin number
+
+    uint32_t _endTime;          // Latch timing reference
+    uint8_t* _data;             // Holds data stream which include LED color values and other settings as needed
+
+    GapCallback _gapCallback;
+    void* _gapContext;
+
+    uint16_t _maxGapUs;
+    uint16_t _gapOverruns;
+
+    bool _sendChunked()
+    {
+        size_t sent = 0;
+        uint32_t gapStart = 0;
+
+        while (sent < _sizeData)
+        {
+            size_t size = (_sizeData - sent < _sizeChunk) ? (_sizeData - sent) : _sizeChunk;
+
+            noInterrupts();
+
+            if (sent != 0)
+            {
+                uint32_t gapUs = micros() - gapStart;
+
+                if (gapUs > _maxGapUs)
+                {
+                    _maxGapUs = (gapUs > 0xffff) ? 0xffff : gapUs;
+                }
+
+                if (gapUs >= GapMaxUs)
+                {
+                    interrupts();
+
+                    return false;
+                }
+            }
+
+            delayMicroseconds(T_SPEED::FrameTimeUs(size));
+
+            gapStart = micros();
+
+            interrupts();
+
+            sent += size;
+
+            if ((_gapCallback) && (sent < _sizeData))
+            {
+                _gapCallback(_gapContext);
+            }
+        }
+
+        return true;
+    }
+};
+
+// Same lanes, planes and gap check as NeoAvrParallelMethodBase, lane 0
+// on port bit 0. The planes sent are turned back into lanes for halLedShow,
+// so a listener sees what every lane got, lane after lane.
+template<typename T_SPEED, uint8_t V_LANES> class NeoHostParallelMethodBase
+{
+public:
+    typedef NeoNoSettings SettingsObject;
+
+    static const uint16_t GapMaxUs = T_SPEED::ResetTimeUs / 2;
+
+    // rough AVR cost of NeoBitPlanes::FromLanes<V_LANES>, about 80 clocks
+    // plus 20 a lane per pixel byte
+    static const uint16_t PlanesNsPerByte = V_LANES * 1250 + 5000;
+
+    NeoHostParallelMethodBase(uint8_t pin, uint16_t pixelCount, size_t elementSize, size_t settingsSize) :
+        _laneSize(((pixelCount + V_LANES - 1) / V_LANES) * elementSize),
+        _sizeData(_laneSize * V_LANES + settingsSize),
+        _elementSize(elementSize),
+        _pin(pin),
+        _endTime(0),
+        _maxGapUs(0),
+        _gapOverruns(0)
+    {
+        pinMode(pin, OUTPUT);
+
+        _data = static_cast<uint8_t*>(malloc(_sizeData));
+        // the tail of the last lane is never set by the bus, keep it dark
+        memset(_data, 0, _sizeData);
+
+        _sent = static_cast<uint8_t*>(malloc(_laneSize * V_LANES));
+        _planes = static_cast<uint8_t*>(malloc(_elementSize * 8));
+    }
+
+    ~NeoHostParallelMethodBase()
+    {
+        pinMode(_pin, INPUT);
+
+        free(_planes);
+        free(_sent);
+        free(_data);
+    }
+
+    bool IsReadyToUpdate() const
+    {
+        uint32_t delta = micros() - _endTime;
+
+        return (delta >= T_SPEED::ResetTimeUs);
+    }
+
+    void Initialize()
+    {
+        digitalWrite(_pin, LOW);
+
+        _endTime = micros();
+    }
+
+    void Update(bool)
+    {
+        while (!IsReadyToUpdate())
+        {
+            yield();
+        }
+
+        uint32_t start = micros();
+
+        if (!_sendPlanes(false))
+        {
+            _gapOverruns++;
+
+            // let the partial frame latch, then send all of it masked
+            _endTime = micros();
+
+            while (!IsReadyToUpdate())
+            {
+                yield();
+            }
+
+            start = micros();
+
+            _sendPlanes(true);
+        }
+
+        // save EOD time for latch on next call
+        _endTime = micros();
+
+        halLedShow(_sent, _laneSize * V_LANES, start, _endTime);
+    }
+
+    uint8_t* getData() const
+    {
+        return _data;
+    };
+
+    size_t getDataSize() const
+    {
+        return _sizeData;
+    };
+
+    void applySettings(const SettingsObject& settings)
+    {
+    }
+
+    uint16_t MaxGapUs() const
+    {
+        return _maxGapUs;
+    }
+
+    uint16_t GapOverruns() const
+    {
+        return _gapOverruns;
+    }
+
+    void ResetGapStats()
+    {
+        _maxGapUs = 0;
+        _gapOverruns = 0;
+    }
+
+private:
+    const size_t  _laneSize;    // bytes per lane
+    const size_t  _sizeData;    // size of _data below
+    const size_t  _elementSize; // bytes per pixel, transposed at a time
+    const uint8_t _pin;         // first lane pin number
+
+    uint32_t _endTime;          // Latch timing reference
+    uint8_t* _data;             // Lane after lane of LED color values
+    uint8_t* _sent;             // Lanes as recovered from the planes sent
+    uint8_t* _planes;           // Bit planes of one pixel of every lane
+
+    uint16_t _maxGapUs;
+    uint16_t _gapOverruns;
+
+    bool _sendPlanes(bool masked)
+    {
+        uint32_t gapStart = 0;
+
+        if (masked)
+        {
+            noInterrupts();
+        }
+
+        for (size_t offset = 0; offset < _laneSize; offset += _elementSize)
+        {
+            NeoBitPlanes::FromLanes<V_LANES>(_data, _laneSize, 0, offset, _elementSize, _planes);
+
+            delayMicroseconds((_elementSize * PlanesNsPerByte + 999) / 1000);
+
+            noInterrupts();
+
+            if (offset != 0)
+            {
+                uint32_t gapUs = micros() - gapStart;
+
+                if (gapUs > _maxGapUs)
+                {
+                    _maxGapUs = (gapUs > 0xffff) ? 0xffff : gapUs;
+                }
+
+                if (!masked && gapUs >= GapMaxUs)
+                {
+                    interrupts();
+
+                    return false;
+                }
+            }
+
+            // one plane per bit period, for all lanes at once
+            delayMicroseconds(T_SPEED::FrameTimeUs(_elementSize));
+
+            NeoBitPlanes::ToLanes(_planes, _laneSize, V_LANES, 0, offset, _elementSize, _sent);
+
+            gapStart = micros();
+
+            if (!masked)
+            {
+                interrupts();
+            }
+        }
+
+        interrupts();
+
+        return true;
+    }
+};
+
+typedef NeoHostMethodBase<NeoHostSpeedWs2812x> NeoHostWs2812xMethod;
+typedef NeoHostMethodBase<NeoHostSpeedSk6812> NeoHostSk6812Method;
+typedef NeoHostMethodBase<NeoHostSpeedTm1814> NeoHostTm1814InvertedMethod;
+typedef NeoHostMethodBase<NeoHostSpeedTm1829> NeoHostTm1829InvertedMethod;
+typedef NeoHostMethodBase<NeoHostSpeed800Kbps> NeoHost800KbpsMethod;
+typedef NeoHostMethodBase<NeoHostSpeed400Kbps> NeoHost400KbpsMethod;
+typedef NeoHostTm1814InvertedMethod NeoHostTm1914InvertedMethod;
+
+// same aliases the AVR build provides, so sketches compile unchanged
+typedef NeoHostWs2812xMethod NeoWs2813Method;
+typedef NeoHostWs2812xMethod NeoWs2812xMethod;
+typedef NeoHost800KbpsMethod NeoWs2812Method;
+typedef NeoHostWs2812xMethod NeoWs2811Method;
+typedef NeoHostSk6812Method NeoSk6812Method;
+typedef NeoHostSk6812Method NeoLc8812Method;
+typedef NeoHost400KbpsMethod NeoApa106Method;
+typedef NeoHostWs2812xMethod Neo800KbpsMethod;
+typedef NeoHost400KbpsMethod Neo400KbpsMethod;
+
+typedef NeoHostChunkedMethodBase<NeoHostSpeedWs2812x> NeoHostChunkedWs2812xMethod;
+typedef NeoHostChunkedMethodBase<NeoHostSpeedSk6812> NeoHostChunkedSk6812Method;
+typedef NeoHostChunkedMethodBase<NeoHostSpeed800Kbps> NeoHostChunked800KbpsMethod;
+
+typedef NeoHostChunkedWs2812xMethod NeoChunkedWs2812xMethod;
+typedef NeoHostChunkedSk6812Method NeoChunkedSk6812Method;
+typedef NeoHostChunkedWs2812xMethod NeoChunked800KbpsMethod;
+
+// X2 barely pays off on the AVR, see NeoAvrParallelMethodBase
+typedef NeoHostParallelMethodBase<NeoHostSpeedWs2812x, 2> NeoHostX2Ws2812xMethod;
+typedef NeoHostParallelMethodBase<NeoHostSpeedWs2812x, 4> NeoHostX4Ws2812xMethod;
+typedef NeoHostParallelMethodBase<NeoHostSpeedWs2812x, 8> NeoHostX8Ws2812xMethod;
+typedef NeoHostParallelMethodBase<NeoHostSpeedSk6812, 2> NeoHostX2Sk6812Method;
+typedef NeoHostParallelMethodBase<NeoHostSpeedSk6812, 4> NeoHostX4Sk6812Method;
+typedef NeoHostParallelMethodBase<NeoHostSpeedSk6812, 8> NeoHostX8Sk6812Method;
+
+typedef NeoHostX2Ws2812xMethod NeoX2Ws2812xMethod;
+typedef NeoHostX4Ws2812xMethod NeoX4Ws2812xMethod;
+typedef NeoHostX8Ws2812xMethod NeoX8Ws2812xMethod;
+typedef NeoHostX2Sk6812Method NeoX2Sk6812Method;
+typedef NeoHostX4Sk6812Method NeoX4Sk6812Method;
+typedef NeoHostX8Sk6812Method NeoX8Sk6812Method;
+
+typedef NeoHostTm1814InvertedMethod NeoTm1814InvertedMethod;
+typedef NeoHostTm1914InvertedMethod NeoTm1914InvertedMethod;
+typedef NeoHostTm1829InvertedMethod NeoTm1829InvertedMethod;
+#endif
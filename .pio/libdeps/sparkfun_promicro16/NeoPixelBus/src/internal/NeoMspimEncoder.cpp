@@ -0,0 +1,30 @@
+/*-------------------------------------------------------------------------
+NeoMspimEncoder symbol table, the 12 SPI bits for each 4 bit nibble.
+
+-------------------------------------------------------------------------
+This file is part of the Makuna/NeoPixelBus library.
+
+NeoPixelBus is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3 of
+the License, or (at your option) any later version.
+
+NeoPixelBus is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with NeoPixel.  If not, see
+<http://www.gnu.org/licenses/>.
+-------------------------------------------------------------------------*/
+
+#include <Arduino.h>
+#include "NeoPixelBus.h"
+
+const uint16_t NeoMspimEncoder::_nibbleTable[16] PROGMEM = {
+    0x924, 0x926, 0x934, 0x936,
+    0x9a4, 0x9a6, 0x9b4, 0x9b6,
+    0xd24, 0xd26, 0xd34, 0xd36,
+    0xda4, 0xda6, 0xdb4, 0xdb6
+};
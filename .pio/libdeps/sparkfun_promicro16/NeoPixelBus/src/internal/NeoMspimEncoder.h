@@ -0,0 +1,51 @@
+/*-------------------------------------------------------------------------
+NeoMspimEncoder turns WS2812 data bytes into the bit pattern a USART in
+SPI master mode (MSPIM) shifts out, three SPI bits per WS2812 bit: 110 for
+a one and 100 for a zero. At 16 MHz with UBRR = 2 an SPI bit is 375 ns, so
+a WS2812 bit is 1.125 us and every data byte is exactly three USART bytes.
+
+It has no hardware dependencies so the waveform can be checked on a host.
+
+-------------------------------------------------------------------------
+This file is part of the Makuna/NeoPixelBus library.
+
+NeoPixelBus is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3 of
+the License, or (at your option) any later version.
+
+NeoPixelBus is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with NeoPixel.  If not, see
+<http://www.gnu.org/licenses/>.
+-------------------------------------------------------------------------*/
+
+#pragma once
+
+class NeoMspimEncoder
+{
+public:
+    static const uint8_t SpiBitsPerBit = 3;
+    static const uint8_t SymbolBytesPerByte = 3;
+
+    // UBRR for the 375 ns SPI bit, baud is F_CPU / (2 * (UBRR + 1))
+    static const uint16_t Ubrr16Mhz = 2;
+
+    static void EncodeByte(uint8_t value, uint8_t* symbols)
+    {
+        uint16_t high = pgm_read_word(_nibbleTable + (value >> 4));
+        uint16_t low = pgm_read_word(_nibbleTable + (value & 0x0f));
+
+        // 12 + 12 bits, most significant first
+        symbols[0] = high >> 4;
+        symbols[1] = (high << 4) | (low >> 8);
+        symbols[2] = low;
+    }
+
+private:
+    static const uint16_t _nibbleTable[16];
+};
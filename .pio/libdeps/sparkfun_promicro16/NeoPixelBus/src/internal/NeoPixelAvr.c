@@ -577,6 +577,51 @@ void send_data_16mhz_800(uint8_t* data, size_t sizeData, volatile uint8_t* port,
         [lo]     "r" (lo));
 }
 
+// One plane byte per bit: the PORT value with every lane's bit for this bit
+// period, as built by NeoBitPlanes. Lanes outside laneMask keep their level.
+void send_planes_16mhz_800(uint8_t* planes, size_t count, volatile uint8_t* port, uint8_t laneMask)
+{
+    volatile uint16_t i = (uint16_t)count; // Loop counter
+    volatile uint8_t* ptr = planes; // Pointer to next plane
+    volatile uint8_t plane = *ptr++; // Current plane
+    volatile uint8_t hi;            // PORT w/all lanes high
+    volatile uint8_t lo;            // PORT w/all lanes low
+    volatile uint8_t next;
+
+    // same timing as send_data_16mhz_800, but the middle store takes the
+    // lanes of the plane rather than testing one bit, so all lanes with a
+    // zero bit drop at T=5 together
+
+    // 20 inst. clocks per bit: HHHHHxxxxxxxxLLLLLLL
+    // ST instructions:         ^   ^        ^       (T=0,5,13)
+
+    hi = *port | laneMask;
+    lo = *port & ~laneMask;
+
+    // the last iteration reads one plane past count, planes must allow it
+    asm volatile(
+        "headplanes20:"             "\n\t" // Clk  Pseudocode    (T =  0)
+        "st   %a[port],  %[hi]"    "\n\t" // 2    PORT = hi     (T =  2)
+        "mov  %[next],  %[lo]"     "\n\t" // 1    next = lo     (T =  3)
+        "or   %[next],  %[plane]"  "\n\t" // 1    next |= plane (T =  4)
+        "nop"                      "\n\t" // 1    nop           (T =  5)
+        "st   %a[port],  %[next]"  "\n\t" // 2    PORT = next   (T =  7)
+        "ld   %[plane], %a[ptr]+"  "\n\t" // 2    plane = *ptr++ (T =  9)
+        "rjmp .+0"                 "\n\t" // 2    nop nop       (T = 11)
+        "rjmp .+0"                 "\n\t" // 2    nop nop       (T = 13)
+        "st   %a[port],  %[lo]"    "\n\t" // 2    PORT = lo     (T = 15)
+        "sbiw %[count], 1"         "\n\t" // 2    i--           (T = 17)
+        "nop"                      "\n\t" // 1    nop           (T = 18)
+        "brne headplanes20"        "\n"   // 2    if(i != 0) -> (next plane)
+        : [port]  "+e" (port),
+        [plane] "+r" (plane),
+        [next]  "+r" (next),
+        [count] "+w" (i),
+        [ptr]   "+e" (ptr)
+        : [hi]     "r" (hi),
+        [lo]     "r" (lo));
+}
+
 void send_data_16mhz_400(uint8_t* data, size_t sizeData, volatile uint8_t* port, uint8_t pinMask)
 {
     volatile size_t i = sizeData; // Loop counter
@@ -167,6 +167,18 @@ RgbColor RgbColor::LinearBlend(const RgbColor& left, const RgbColor& right, floa
         left.B + ((right.B - left.B) * progress));
 }
 
+RgbColor RgbColor::LinearBlend8(const RgbColor& left, const RgbColor& right, uint8_t progress)
+{
+    // weights sum to 256 and the total stays within 16 bits; 0 maps to
+    // exactly left and 255 to exactly right
+    uint16_t weightRight = (uint16_t)progress + (progress >> 7);
+    uint16_t weightLeft = 256 - weightRight;
+
+    return RgbColor((left.R * weightLeft + right.R * weightRight) >> 8,
+        (left.G * weightLeft + right.G * weightRight) >> 8,
+        (left.B * weightLeft + right.B * weightRight) >> 8);
+}
+
 RgbColor RgbColor::BilinearBlend(const RgbColor& c00, 
     const RgbColor& c01, 
     const RgbColor& c10, 
@@ -149,6 +149,12 @@ struct RgbColor : RgbColorBase
     //     and a value between will blend the color weighted linearly between them
     // ------------------------------------------------------------------------
     static RgbColor LinearBlend(const RgbColor& left, const RgbColor& right, float progress);
+
+    // ------------------------------------------------------------------------
+    // LinearBlend8 between two colors without floating point
+    // progress - (0 - 255) value where 0 will return left and 255 will return right
+    // ------------------------------------------------------------------------
+    static RgbColor LinearBlend8(const RgbColor& left, const RgbColor& right, uint8_t progress);
     
     // ------------------------------------------------------------------------
     // BilinearBlend between four colors by the amount defined by 2d variable
@@ -0,0 +1,516 @@
+// Press-to-HID latency benchmarks of the paws master firmware on the host HAL.
+//
+//   paws-bench [--scenario NAME] [--presses N] [--seed N] [--json]
+//              [--max-p99-us N]
+//
+// Every scenario boots the firmware against a simulated module chain,
+// uploads a config binding a letter to each of the first buttons, then plays
+// a scripted timeline of presses and releases. Latency is measured from the
+// module's I2C write to the HID().SendReport call that shows the edge. An
+// edge that never shows in a report is dropped.
+//
+// With --json, one JSON object per scenario is printed per line. With
+// --max-p99-us, the exit status is 1 if any scenario's p99 press or release
+// latency is above it.
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include <Arduino.h>
+
+#include "../sim/ModuleChain.h"
+
+#define SERIAL_REQUEST_BEGIN 0x42
+#define SERIAL_CONFIG_UPLOAD 0x41
+
+#define CONFIG_BEGIN 0x4242
+#define CONFIG_KEY 0x01
+#define CONFIG_LED 0x02
+#define CONFIG_ANIMATION 0x03
+
+#define ANIMATION_GRADIENT 0
+#define ANIMATION_STILL 2
+
+#define BTN_PRESS_TYPE_ONCE 0
+#define BTN_PRESS_TYPE_CONT 1
+
+// Keyboard report: | modifiers | reserved | keys (6) |
+#define HID_REPORT_ID 2
+#define HID_REPORT_KEYS_IDX 2
+#define HID_REPORT_KEYS 6
+
+// Letters a..t, one per bound button, so an edge maps to one button
+#define BENCH_BOUND_BTNS 20
+
+// A button is pressed again no sooner than this after its release, so a
+// report up to then can only belong to that press
+#define BENCH_REARM_US 5000
+
+struct scenario_s
+{
+	const char* name;
+	const char* desc;
+	size_t modules;
+	uint8_t animation;
+	// Buttons bound to continuous keys, held down across the timeline
+	uint8_t repeatBtns;
+	bool uploadInFlight;
+};
+
+static const struct scenario_s scenarios[] = {
+	{ "baseline", "6 modules, still LEDs", 6, ANIMATION_STILL, 0, false },
+	{ "show128", "128 modules, still LEDs, Show() on every press", 128, ANIMATION_STILL, 0, false },
+	{ "gradient128", "128 modules, Gradient animation on the bound buttons", 128, ANIMATION_GRADIENT, 0, false },
+	{ "upload", "6 modules, config uploads in flight", 6, ANIMATION_STILL, 0, true },
+	{ "repeat", "6 modules, 2 continuous keys repeating", 6, ANIMATION_STILL, 2, false },
+};
+
+struct press_s
+{
+	uint8_t btn;
+	uint8_t usage;
+	uint32_t pressUs;
+	uint32_t releaseUs;
+	bool measureRelease;
+};
+
+struct report_s
+{
+	uint32_t queuedUs;
+	uint8_t keys[HID_REPORT_KEYS];
+};
+
+struct result_s
+{
+	std::vector<uint32_t> pressLatency;
+	std::vector<uint32_t> releaseLatency;
+	std::vector<uint32_t> loopPeriod;
+	uint32_t edges;
+	uint32_t dropped;
+	uint32_t uploads;
+};
+
+class ReportLog : public HalHidListener
+{
+public:
+	std::vector<struct report_s> reports;
+
+	void onReport(uint8_t id, const uint8_t* data, size_t len, uint32_t queuedUs, uint32_t deliveredUs)
+	{
+		struct report_s r;
+
+		(void)deliveredUs;
+
+		if ((id != HID_REPORT_ID) || (len < HID_REPORT_KEYS_IDX + HID_REPORT_KEYS))
+		{
+			return;
+		}
+
+		r.queuedUs = queuedUs;
+		memcpy(r.keys, data + HID_REPORT_KEYS_IDX, HID_REPORT_KEYS);
+
+		reports.push_back(r);
+	}
+};
+
+static uint32_t benchSeed = 1;
+
+static uint32_t benchRand()
+{
+	benchSeed = benchSeed * 1103515245 + 12345;
+
+	return (benchSeed >> 16) & 0x7fff;
+}
+
+static uint8_t letterUsage(uint8_t btn)
+{
+	return 0x04 + btn;
+}
+
+static bool reportHas(const struct report_s& r, uint8_t usage)
+{
+	for (int i = 0; i < HID_REPORT_KEYS; ++i)
+	{
+		if (r.keys[i] == usage)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static void configObj(std::vector<uint8_t>& cfg, uint8_t type, uint8_t btn, uint8_t a, uint8_t b, uint8_t c, uint8_t d)
+{
+	const uint8_t obj[8] = { type, btn, a, b, c, d, 0, 0 };
+
+	cfg.insert(cfg.end(), obj, obj + sizeof(obj));
+}
+
+// Upload request for the scenario's config. variant only changes LED colors.
+static std::vector<uint8_t> configRequest(const struct scenario_s& sc, uint8_t variant)
+{
+	std::vector<uint8_t> cfg;
+	std::vector<uint8_t> req;
+	size_t btns = std::min(sc.modules, (size_t)BENCH_BOUND_BTNS);
+	uint16_t objnum;
+
+	cfg.push_back(CONFIG_BEGIN & 0xff);
+	cfg.push_back(CONFIG_BEGIN >> 8);
+	cfg.push_back(0);
+	cfg.push_back(0);
+
+	for (size_t b = 0; b < btns; ++b)
+	{
+		uint8_t pressType = (b < sc.repeatBtns) ? BTN_PRESS_TYPE_CONT : BTN_PRESS_TYPE_ONCE;
+
+		configObj(cfg, CONFIG_KEY, b, 'a' + b, pressType, 0, 0);
+		configObj(cfg, CONFIG_ANIMATION, b, 0x20 + variant, 0x40, 0x80, sc.animation);
+	}
+
+	objnum = (cfg.size() - 4) / 8;
+	cfg[2] = objnum & 0xff;
+	cfg[3] = objnum >> 8;
+
+	req.push_back(SERIAL_REQUEST_BEGIN);
+	req.push_back(SERIAL_CONFIG_UPLOAD);
+	req.push_back(SERIAL_CONFIG_UPLOAD);
+	req.push_back(cfg.size() & 0xff);
+	req.push_back(cfg.size() >> 8);
+	req.insert(req.end(), cfg.begin(), cfg.end());
+
+	return req;
+}
+
+// Run loop() until the firmware acks the upload
+static bool uploadConfig(const std::vector<uint8_t>& req)
+{
+	uint8_t buf[256];
+	size_t n;
+
+	while (halSerialTakeOutput(buf, sizeof(buf)))
+		;
+
+	halSerialInject(req.data(), req.size());
+
+	for (unsigned long i = 0; i < 10000000; ++i)
+	{
+		loop();
+
+		// Acked with 0xff, errors are text lines
+		if ((n = halSerialTakeOutput(buf, sizeof(buf))) > 0)
+		{
+			if (buf[n - 1] == 0xff)
+			{
+				return true;
+			}
+
+			if (buf[n - 1] == '\n')
+			{
+				return false;
+			}
+		}
+	}
+
+	return false;
+}
+
+// Taps of random bound buttons. Only one tap of a given button at a time,
+// so every edge maps to one press.
+static std::vector<struct press_s> buildTimeline(const struct scenario_s& sc, uint32_t startUs, unsigned presses)
+{
+	std::vector<struct press_s> timeline;
+	std::vector<uint32_t> freeAt(BENCH_BOUND_BTNS, startUs);
+	size_t btns = std::min(sc.modules, (size_t)BENCH_BOUND_BTNS);
+	uint32_t atUs = startUs;
+	uint32_t endUs;
+
+	for (unsigned i = 0; i < presses; ++i)
+	{
+		struct press_s p;
+
+		// Button still held: wait a bit and pick again
+		while ((int32_t)(freeAt[p.btn = sc.repeatBtns + benchRand() % (btns - sc.repeatBtns)] - atUs) > 0)
+		{
+			atUs += 1000;
+		}
+
+		p.usage = letterUsage(p.btn);
+		p.pressUs = atUs;
+		p.releaseUs = atUs + 20000 + benchRand() % 60000;
+		p.measureRelease = true;
+
+		freeAt[p.btn] = p.releaseUs + BENCH_REARM_US;
+
+		timeline.push_back(p);
+
+		// Overlapping taps, 0..40 ms apart
+		atUs += benchRand() % 40000;
+	}
+
+	endUs = atUs + 80000;
+
+	// Continuous keys held across the whole timeline. Their release is
+	// followed by repeats, so only the press is measured.
+	for (uint8_t b = 0; b < sc.repeatBtns; ++b)
+	{
+		struct press_s p;
+
+		p.btn = b;
+		p.usage = letterUsage(b);
+		p.pressUs = startUs + b * 1000;
+		p.releaseUs = endUs;
+		p.measureRelease = false;
+
+		timeline.push_back(p);
+	}
+
+	return timeline;
+}
+
+static uint32_t percentile(std::vector<uint32_t> v, double q)
+{
+	if (v.empty())
+	{
+		return 0;
+	}
+
+	std::sort(v.begin(), v.end());
+
+	return v[(size_t)((v.size() - 1) * q + 0.5)];
+}
+
+static uint32_t maximum(const std::vector<uint32_t>& v)
+{
+	return v.empty() ? 0 : *std::max_element(v.begin(), v.end());
+}
+
+static void matchEdges(const std::vector<struct press_s>& timeline, const std::vector<struct report_s>& reports, struct result_s* res)
+{
+	for (size_t i = 0; i < timeline.size(); ++i)
+	{
+		const struct press_s& p = timeline[i];
+		size_t r = 0;
+
+		// First report after the press showing the key. A key pressed with
+		// six others held never shows, and neither does its release.
+		while ((r < reports.size()) && (((int32_t)(reports[r].queuedUs - p.pressUs) < 0) || !reportHas(reports[r], p.usage)))
+		{
+			r++;
+		}
+
+		res->edges += p.measureRelease ? 2 : 1;
+
+		if ((r == reports.size()) || ((int32_t)(reports[r].queuedUs - (p.releaseUs + BENCH_REARM_US)) >= 0))
+		{
+			res->dropped += p.measureRelease ? 2 : 1;
+
+			continue;
+		}
+
+		res->pressLatency.push_back(reports[r].queuedUs - p.pressUs);
+
+		if (!p.measureRelease)
+		{
+			continue;
+		}
+
+		// First report after the release not showing it
+		while ((r < reports.size()) && (((int32_t)(reports[r].queuedUs - p.releaseUs) < 0) || reportHas(reports[r], p.usage)))
+		{
+			r++;
+		}
+
+		if (r == reports.size())
+		{
+			res->dropped++;
+
+			continue;
+		}
+
+		res->releaseLatency.push_back(reports[r].queuedUs - p.releaseUs);
+	}
+}
+
+static bool runScenario(const struct scenario_s& sc, unsigned presses, struct result_s* res)
+{
+	module_chain_config_s config = ModuleChain::defaultConfig();
+	ReportLog log;
+	std::vector<struct press_s> timeline;
+	std::vector<uint8_t> uploads[2];
+	uint32_t endUs = 0;
+	uint8_t buf[256];
+	size_t n;
+
+	res->edges = 0;
+	res->dropped = 0;
+	res->uploads = 0;
+
+	halReset();
+
+	config.seed = benchSeed;
+
+	ModuleChain chain(sc.modules, config);
+
+	chain.attach();
+
+	setup();
+
+	uploads[0] = configRequest(sc, 0);
+	uploads[1] = configRequest(sc, 1);
+
+	if (!uploadConfig(uploads[0]))
+	{
+		fprintf(stderr, "%s: config upload failed\n", sc.name);
+
+		return false;
+	}
+
+	// Let the LEDs settle on the config
+	for (int i = 0; i < 10000; ++i)
+	{
+		loop();
+	}
+
+	timeline = buildTimeline(sc, halMicros() + 1000, presses);
+
+	for (size_t i = 0; i < timeline.size(); ++i)
+	{
+		chain.press(timeline[i].btn, timeline[i].pressUs);
+		chain.release(timeline[i].btn, timeline[i].releaseUs);
+
+		endUs = std::max(endUs, timeline[i].releaseUs);
+	}
+
+	halSetHidListener(&log);
+
+	if (sc.uploadInFlight)
+	{
+		halSerialInject(uploads[1].data(), uploads[1].size());
+	}
+
+	// Play the timeline out, plus time for the last edges to show
+	while ((int32_t)(halMicros() - (endUs + 50000)) < 0)
+	{
+		uint32_t t = halMicros();
+
+		loop();
+
+		res->loopPeriod.push_back(halMicros() - t);
+
+		// Keep an upload going, alternating configs so each one writes
+		if ((sc.uploadInFlight) && ((n = halSerialTakeOutput(buf, sizeof(buf))) > 0) && (buf[n - 1] == 0xff))
+		{
+			res->uploads++;
+
+			halSerialInject(uploads[res->uploads & 1].data(), uploads[res->uploads & 1].size());
+		}
+	}
+
+	halSetHidListener(NULL);
+
+	// Let the last upload finish, the firmware's state outlives halReset()
+	// and the next scenario would start mid-upload
+	while ((sc.uploadInFlight) && (!(((n = halSerialTakeOutput(buf, sizeof(buf))) > 0) &&
+		((buf[n - 1] == 0xff) || (buf[n - 1] == '\n')))))
+	{
+		loop();
+	}
+
+	matchEdges(timeline, log.reports, res);
+
+	return true;
+}
+
+static void printResult(const struct scenario_s& sc, const struct result_s& res, bool json)
+{
+	if (json)
+	{
+		printf("{\"scenario\":\"%s\",\"modules\":%zu,\"edges\":%u,\"dropped\":%u,\"uploads\":%u,"
+			"\"press_p50_us\":%u,\"press_p99_us\":%u,\"press_max_us\":%u,"
+			"\"release_p50_us\":%u,\"release_p99_us\":%u,\"release_max_us\":%u,"
+			"\"loop_p50_us\":%u,\"loop_p99_us\":%u,\"loop_max_us\":%u}\n",
+			sc.name, sc.modules, res.edges, res.dropped, res.uploads,
+			percentile(res.pressLatency, 0.5), percentile(res.pressLatency, 0.99), maximum(res.pressLatency),
+			percentile(res.releaseLatency, 0.5), percentile(res.releaseLatency, 0.99), maximum(res.releaseLatency),
+			percentile(res.loopPeriod, 0.5), percentile(res.loopPeriod, 0.99), maximum(res.loopPeriod));
+
+		return;
+	}
+
+	printf("%s: %s\n", sc.name, sc.desc);
+	printf("  edges %u, dropped %u", res.edges, res.dropped);
+
+	if (sc.uploadInFlight)
+	{
+		printf(", uploads %u", res.uploads);
+	}
+
+	printf("\n");
+	printf("  %-8s %8s %8s %8s (us)\n", "", "p50", "p99", "max");
+	printf("  %-8s %8u %8u %8u\n", "press", percentile(res.pressLatency, 0.5), percentile(res.pressLatency, 0.99), maximum(res.pressLatency));
+	printf("  %-8s %8u %8u %8u\n", "release", percentile(res.releaseLatency, 0.5), percentile(res.releaseLatency, 0.99), maximum(res.releaseLatency));
+	printf("  %-8s %8u %8u %8u\n", "loop", percentile(res.loopPeriod, 0.5), percentile(res.loopPeriod, 0.99), maximum(res.loopPeriod));
+}
+
+int main(int argc, char** argv)
+{
+	const char* only = NULL;
+	unsigned presses = 200;
+	unsigned long maxP99Us = 0;
+	bool json = false;
+	int status = 0;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (!strcmp(argv[i], "--scenario") && (i + 1 < argc))
+			only = argv[++i];
+		else if (!strcmp(argv[i], "--presses") && (i + 1 < argc))
+			presses = strtoul(argv[++i], NULL, 0);
+		else if (!strcmp(argv[i], "--seed") && (i + 1 < argc))
+			benchSeed = strtoul(argv[++i], NULL, 0);
+		else if (!strcmp(argv[i], "--max-p99-us") && (i + 1 < argc))
+			maxP99Us = strtoul(argv[++i], NULL, 0);
+		else if (!strcmp(argv[i], "--json"))
+			json = true;
+		else
+		{
+			fprintf(stderr, "usage: %s [--scenario NAME] [--presses N] [--seed N] [--json] [--max-p99-us N]\n", argv[0]);
+
+			for (size_t s = 0; s < sizeof(scenarios) / sizeof(scenarios[0]); ++s)
+			{
+				fprintf(stderr, "  %-12s %s\n", scenarios[s].name, scenarios[s].desc);
+			}
+
+			return 1;
+		}
+	}
+
+	for (size_t s = 0; s < sizeof(scenarios) / sizeof(scenarios[0]); ++s)
+	{
+		struct result_s res;
+
+		if ((only) && (strcmp(only, scenarios[s].name)))
+		{
+			continue;
+		}
+
+		if (!runScenario(scenarios[s], presses, &res))
+		{
+			return 1;
+		}
+
+		printResult(scenarios[s], res, json);
+
+		if ((maxP99Us) && ((percentile(res.pressLatency, 0.99) > maxP99Us) || (percentile(res.releaseLatency, 0.99) > maxP99Us)))
+		{
+			fprintf(stderr, "%s: p99 latency above %lu us\n", scenarios[s].name, maxP99Us);
+
+			status = 1;
+		}
+	}
+
+	return status;
+}
@@ -0,0 +1,179 @@
+// Accuracy of the NeoEase8 and NeoEase16 fixed point easing curves against
+// the float NeoEase they stand in for.
+//
+//   paws-ease [--json] [--max-lsb8 N] [--max-lsb16 N]
+//
+// Every curve is evaluated at all 256 (NeoEase8) and all 65536 (NeoEase16)
+// unit values and compared with NeoEase at the same value scaled to the same
+// range. Errors are in LSBs of the fixed point result. With --json, one JSON
+// object per curve is printed per line. With --max-lsb8 or --max-lsb16, the
+// exit status is 1 if any curve's worst error is above it.
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <NeoPixelBus.h>
+
+#define EASE_CURVE(name) { #name, NeoEase::name, NeoEase8::name, NeoEase16::name }
+
+struct ease_curve_s
+{
+	const char* name;
+	float (*reference)(float unitValue);
+	AnimEaseFunction8 ease8;
+	AnimEaseFunction16 ease16;
+};
+
+struct ease_error_s
+{
+	double max;
+	double mean;
+	uint32_t worstAt;
+};
+
+static const struct ease_curve_s curves[] = {
+	EASE_CURVE(Linear),
+	EASE_CURVE(QuadraticIn),
+	EASE_CURVE(QuadraticOut),
+	EASE_CURVE(QuadraticInOut),
+	EASE_CURVE(QuadraticCenter),
+	EASE_CURVE(CubicIn),
+	EASE_CURVE(CubicOut),
+	EASE_CURVE(CubicInOut),
+	EASE_CURVE(CubicCenter),
+	EASE_CURVE(QuarticIn),
+	EASE_CURVE(QuarticOut),
+	EASE_CURVE(QuarticInOut),
+	EASE_CURVE(QuarticCenter),
+	EASE_CURVE(QuinticIn),
+	EASE_CURVE(QuinticOut),
+	EASE_CURVE(QuinticInOut),
+	EASE_CURVE(QuinticCenter),
+	EASE_CURVE(SinusoidalIn),
+	EASE_CURVE(SinusoidalOut),
+	EASE_CURVE(SinusoidalInOut),
+	EASE_CURVE(SinusoidalCenter),
+	EASE_CURVE(ExponentialIn),
+	EASE_CURVE(ExponentialOut),
+	EASE_CURVE(ExponentialInOut),
+	EASE_CURVE(ExponentialCenter),
+	EASE_CURVE(CircularIn),
+	EASE_CURVE(CircularOut),
+	EASE_CURVE(CircularInOut),
+	EASE_CURVE(CircularCenter),
+	EASE_CURVE(Gamma),
+};
+
+static void measure8(const struct ease_curve_s* curve, struct ease_error_s* error)
+{
+	double total = 0;
+
+	memset(error, 0, sizeof(*error));
+
+	for (uint32_t value = 0; value <= 0xff; ++value)
+	{
+		double expected = 255.0 * curve->reference(value / 255.0f);
+		double diff = fabs(curve->ease8(value) - expected);
+
+		if (diff > error->max)
+		{
+			error->max = diff;
+			error->worstAt = value;
+		}
+
+		total += diff;
+	}
+
+	error->mean = total / 256;
+}
+
+static void measure16(const struct ease_curve_s* curve, struct ease_error_s* error)
+{
+	double total = 0;
+
+	memset(error, 0, sizeof(*error));
+
+	for (uint32_t value = 0; value <= 0xffff; ++value)
+	{
+		double expected = 65535.0 * curve->reference(value / 65535.0f);
+		double diff = fabs(curve->ease16(value) - expected);
+
+		if (diff > error->max)
+		{
+			error->max = diff;
+			error->worstAt = value;
+		}
+
+		total += diff;
+	}
+
+	error->mean = total / 65536;
+}
+
+int main(int argc, char** argv)
+{
+	bool json = false;
+	double maxLsb8 = -1;
+	double maxLsb16 = -1;
+	int status = 0;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (!strcmp(argv[i], "--json"))
+			json = true;
+		else if (!strcmp(argv[i], "--max-lsb8") && (i + 1 < argc))
+			maxLsb8 = strtod(argv[++i], NULL);
+		else if (!strcmp(argv[i], "--max-lsb16") && (i + 1 < argc))
+			maxLsb16 = strtod(argv[++i], NULL);
+		else
+		{
+			fprintf(stderr, "usage: %s [--json] [--max-lsb8 N] [--max-lsb16 N]\n", argv[0]);
+
+			return 1;
+		}
+	}
+
+	if (!json)
+	{
+		printf("%-18s %10s %10s %8s %10s %10s %8s\n", "curve", "8 max", "8 mean", "8 at",
+			"16 max", "16 mean", "16 at");
+	}
+
+	for (size_t i = 0; i < sizeof(curves) / sizeof(curves[0]); ++i)
+	{
+		struct ease_error_s error8;
+		struct ease_error_s error16;
+
+		measure8(&curves[i], &error8);
+		measure16(&curves[i], &error16);
+
+		if (json)
+		{
+			printf("{\"curve\":\"%s\",\"max_lsb8\":%.3f,\"mean_lsb8\":%.3f,\"worst_at8\":%u,"
+				"\"max_lsb16\":%.3f,\"mean_lsb16\":%.3f,\"worst_at16\":%u}\n", curves[i].name,
+				error8.max, error8.mean, error8.worstAt, error16.max, error16.mean, error16.worstAt);
+		}
+		else
+		{
+			printf("%-18s %10.3f %10.3f %8u %10.3f %10.3f %8u\n", curves[i].name,
+				error8.max, error8.mean, error8.worstAt, error16.max, error16.mean, error16.worstAt);
+		}
+
+		if (((maxLsb8 >= 0) && (error8.max > maxLsb8)) || ((maxLsb16 >= 0) && (error16.max > maxLsb16)))
+		{
+			status = 1;
+		}
+	}
+
+	return status;
+}
+
+// The HAL expects a sketch
+void setup(void)
+{
+}
+
+void loop(void)
+{
+}
@@ -0,0 +1,100 @@
+// Host (Linux) emulation of the subset of the Arduino AVR core used by the
+// paws master firmware and its libraries. Time is virtual: it only advances
+// through delay()/delayMicroseconds(), the small per-call cost charged by the
+// emulated peripherals, and explicit halAdvanceMicros() calls from a harness.
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+
+#include "avr/pgmspace.h"
+
+#define ARDUINO 10813
+#define ARDUINO_HOST_HAL 1
+
+#ifndef F_CPU
+#define F_CPU 16000000UL
+#endif
+
+// ATmega32U4 EEPROM is 1 KB
+#ifndef E2END
+#define E2END 0x3FF
+#endif
+
+#define HIGH 0x1
+#define LOW 0x0
+
+#define INPUT 0x0
+#define OUTPUT 0x1
+#define INPUT_PULLUP 0x2
+
+#define NUM_DIGITAL_PINS 31
+
+// Pro Micro hardware SPI pins
+#define SS 17
+#define MOSI 16
+#define MISO 14
+#define SCK 15
+
+#define PI 3.1415926535897932384626433832795
+#define HALF_PI 1.5707963267948966192313216916398
+#define TWO_PI 6.283185307179586476925286766559
+#define DEG_TO_RAD 0.017453292519943295769236907684886
+#define RAD_TO_DEG 57.295779513082320876798154814105
+
+typedef uint8_t byte;
+typedef bool boolean;
+typedef unsigned int word;
+
+#define lowByte(w) ((uint8_t)((w) & 0xff))
+#define highByte(w) ((uint8_t)((w) >> 8))
+
+#define bitRead(value, bit) (((value) >> (bit)) & 0x01)
+#define bitSet(value, bit) ((value) |= (1UL << (bit)))
+#define bitClear(value, bit) ((value) &= ~(1UL << (bit)))
+#define bit(b) (1UL << (b))
+
+// Functions rather than the AVR core macros, so the C++ standard headers stay usable
+template<class T, class L> static inline auto min(const T& a, const L& b) -> decltype((b < a) ? b : a)
+{
+	return (b < a) ? b : a;
+}
+
+template<class T, class L> static inline auto max(const T& a, const L& b) -> decltype((b < a) ? b : a)
+{
+	return (a < b) ? b : a;
+}
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+unsigned long millis(void);
+unsigned long micros(void);
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield(void);
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+
+void noInterrupts(void);
+void interrupts(void);
+
+// Sketch entry points
+void setup(void);
+void loop(void);
+
+long random(long howbig);
+long random(long howsmall, long howbig);
+void randomSeed(unsigned long seed);
+
+#include "WString.h"
+#include "Print.h"
+#include "Stream.h"
+#include "USBAPI.h"
+#include "ArduinoHal.h"
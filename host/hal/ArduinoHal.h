@@ -0,0 +1,128 @@
+// Control surface of the host HAL. Firmware code never includes this directly;
+// it is meant for runners, simulators and benchmarks that drive setup()/loop()
+// against the emulated peripherals.
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// ***** Virtual clock *****
+// Current virtual time, without charging the per-call cost micros() charges
+uint32_t halMicros(void);
+
+// Advance the virtual clock, running every event that falls due on the way
+void halAdvanceMicros(uint32_t us);
+
+// Time charged to every clock/pin/serial poll so busy-wait loops make progress
+void halSetCallCostMicros(uint32_t us);
+
+// Reset clock, pins, event queue, serial buffers, EEPROM and peripherals
+void halReset(void);
+
+// ***** Events and interrupts *****
+typedef void (*hal_event_fn)(void* ctx);
+
+// Run fn at virtual time atUs. Interrupt events are held back while the
+// firmware has interrupts disabled and delivered when they are re-enabled.
+void halScheduleEvent(uint32_t atUs, hal_event_fn fn, void* ctx);
+void halScheduleInterrupt(uint32_t atUs, hal_event_fn fn, void* ctx);
+
+bool halInterruptsEnabled(void);
+
+// Longest stretch the firmware kept interrupts disabled, in microseconds
+uint32_t halMaxInterruptsOffMicros(void);
+
+// Number of interrupts that had to wait for interrupts() to be delivered
+uint32_t halDeferredInterrupts(void);
+
+// ***** GPIO *****
+class HalPinListener
+{
+public:
+	virtual ~HalPinListener() {}
+
+	virtual void onPinWrite(uint8_t pin, uint8_t val) = 0;
+};
+
+void halSetPinListener(HalPinListener* listener);
+
+// Drive the level the firmware reads back from an input pin
+void halSetPinInput(uint8_t pin, uint8_t val);
+
+// Last level the firmware wrote to an output pin
+uint8_t halPinOutput(uint8_t pin);
+
+// ***** USB CDC serial *****
+void halSerialInject(const uint8_t* data, size_t len);
+size_t halSerialOutputAvailable(void);
+size_t halSerialTakeOutput(uint8_t* buf, size_t len);
+
+// Echo everything the firmware prints to stdout
+void halSerialSetEcho(bool echo);
+
+// ***** I2C *****
+class HalI2cBus
+{
+public:
+	virtual ~HalI2cBus() {}
+
+	// Master write from the firmware. Return true if the address ACKed.
+	virtual bool masterWrite(uint8_t addr, const uint8_t* data, size_t len) = 0;
+
+	// Master read from the firmware. Return the number of bytes supplied,
+	// 0 meaning the address NACKed.
+	virtual size_t masterRead(uint8_t addr, uint8_t* data, size_t len) = 0;
+};
+
+void halSetI2cBus(HalI2cBus* bus);
+
+// Clock rate used to charge bus time for master transactions
+void halSetI2cClock(uint32_t hz);
+
+// Virtual time one byte (plus ACK) occupies on the bus
+uint32_t halI2cByteMicros(void);
+
+// Write from another bus master to addr, arriving at atUs. Dropped if the
+// firmware is not listening on addr at delivery time.
+void halI2cSlaveWrite(uint32_t atUs, uint8_t addr, const uint8_t* data, size_t len);
+
+uint32_t halI2cSlaveWritesDropped(void);
+
+// ***** EEPROM *****
+uint8_t* halEepromData(void);
+size_t halEepromSize(void);
+
+// Number of times a cell has been programmed since halReset()
+uint32_t halEepromCellWrites(size_t addr);
+uint32_t halEepromTotalWrites(void);
+
+// Virtual time a single byte program operation keeps the EEPROM busy
+void halSetEepromWriteMicros(uint32_t us);
+
+// ***** USB HID *****
+class HalHidListener
+{
+public:
+	virtual ~HalHidListener() {}
+
+	// queuedUs is when the firmware called SendReport, deliveredUs the USB
+	// frame in which the host picks the report up.
+	virtual void onReport(uint8_t id, const uint8_t* data, size_t len, uint32_t queuedUs, uint32_t deliveredUs) = 0;
+};
+
+void halSetHidListener(HalHidListener* listener);
+uint32_t halHidReports(void);
+
+// ***** LED output *****
+class HalLedListener
+{
+public:
+	virtual ~HalLedListener() {}
+
+	virtual void onShow(const uint8_t* data, size_t len, uint32_t startUs, uint32_t endUs) = 0;
+};
+
+void halSetLedListener(HalLedListener* listener);
+
+// Called by the host NeoPixelBus method for every transmitted frame
+void halLedShow(const uint8_t* data, size_t len, uint32_t startUs, uint32_t endUs);
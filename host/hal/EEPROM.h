@@ -0,0 +1,40 @@
+// Host EEPROM with the AVR programming latency: a byte write keeps the array
+// busy for a few milliseconds and any later access waits it out.
+#pragma once
+
+#include <stdint.h>
+
+#include "avr/eeprom.h"
+
+struct EEPROMClass
+{
+	void begin() {}
+	void end() {}
+
+	uint8_t read(int idx) { return eeprom_read_byte((const uint8_t*)(intptr_t)idx); }
+	void write(int idx, uint8_t val) { eeprom_write_byte((uint8_t*)(intptr_t)idx, val); }
+	void update(int idx, uint8_t val) { eeprom_update_byte((uint8_t*)(intptr_t)idx, val); }
+	uint16_t length() { return E2END + 1; }
+
+	template<typename T> T& get(int idx, T& t)
+	{
+		uint8_t* ptr = (uint8_t*)&t;
+
+		for (unsigned i = 0; i < sizeof(T); ++i)
+			ptr[i] = read(idx + i);
+
+		return t;
+	}
+
+	template<typename T> const T& put(int idx, const T& t)
+	{
+		const uint8_t* ptr = (const uint8_t*)&t;
+
+		for (unsigned i = 0; i < sizeof(T); ++i)
+			update(idx + i, ptr[i]);
+
+		return t;
+	}
+};
+
+extern EEPROMClass EEPROM;
@@ -0,0 +1,32 @@
+// Host pluggable HID core: reports are timestamped and handed to the harness.
+#pragma once
+
+#include <stdint.h>
+
+#include "Arduino.h"
+
+#define _USING_HID
+
+class HIDSubDescriptor
+{
+public:
+	HIDSubDescriptor(const void* d, const uint16_t l) : data(d), length(l), next(NULL) {}
+
+	const void* data;
+	const uint16_t length;
+	HIDSubDescriptor* next;
+};
+
+class HID_
+{
+public:
+	HID_() : rootNode(NULL) {}
+
+	int SendReport(uint8_t id, const void* data, int len);
+	void AppendDescriptor(HIDSubDescriptor* node);
+
+private:
+	HIDSubDescriptor* rootNode;
+};
+
+HID_& HID();
@@ -0,0 +1,68 @@
+// Host Print base class.
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "WString.h"
+
+class Print
+{
+public:
+	Print() : _writeError(0) {}
+	virtual ~Print() {}
+
+	virtual size_t write(uint8_t) = 0;
+
+	virtual size_t write(const uint8_t* buffer, size_t size)
+	{
+		size_t n = 0;
+
+		while (size--)
+		{
+			if (write(*buffer++))
+				n++;
+			else
+				break;
+		}
+
+		return n;
+	}
+
+	size_t write(const char* str)
+	{
+		if (str == NULL)
+			return 0;
+
+		return write((const uint8_t*)str, strlen(str));
+	}
+
+	size_t write(const char* buffer, size_t size) { return write((const uint8_t*)buffer, size); }
+
+	size_t print(const String& s) { return write(s.c_str()); }
+	size_t print(const char* s) { return write(s); }
+	size_t print(char c) { return write((uint8_t)c); }
+	size_t print(int n) { return print(String(n)); }
+	size_t print(unsigned int n) { return print(String(n)); }
+	size_t print(long n) { return print(String(n)); }
+	size_t print(unsigned long n) { return print(String(n)); }
+
+	size_t println() { return write("\r\n"); }
+
+	template<typename T> size_t println(const T& value)
+	{
+		size_t n = print(value);
+
+		return n + println();
+	}
+
+	int getWriteError() { return _writeError; }
+	void clearWriteError() { _writeError = 0; }
+
+protected:
+	void setWriteError(int err = 1) { _writeError = err; }
+
+private:
+	int _writeError;
+};
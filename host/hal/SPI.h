@@ -0,0 +1,32 @@
+// Host SPI: transfers are discarded.
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define MSBFIRST 1
+#define LSBFIRST 0
+#define SPI_MODE0 0x00
+#define SPI_MODE1 0x04
+#define SPI_MODE2 0x08
+#define SPI_MODE3 0x0C
+
+class SPISettings
+{
+public:
+	SPISettings() {}
+	SPISettings(uint32_t clock, uint8_t bitOrder, uint8_t dataMode) { (void)clock; (void)bitOrder; (void)dataMode; }
+};
+
+class SPIClass
+{
+public:
+	static void begin() {}
+	static void end() {}
+	static void beginTransaction(SPISettings) {}
+	static void endTransaction() {}
+	static uint8_t transfer(uint8_t data) { return data; }
+	static void transfer(void* buf, size_t count) { (void)buf; (void)count; }
+};
+
+extern SPIClass SPI;
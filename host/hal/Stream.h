@@ -0,0 +1,25 @@
+// Host Stream base class.
+#pragma once
+
+#include "Print.h"
+
+class Stream : public Print
+{
+public:
+	Stream() : _timeout(1000) {}
+
+	virtual int available() = 0;
+	virtual int read() = 0;
+	virtual int peek() = 0;
+
+	void setTimeout(unsigned long timeout) { _timeout = timeout; }
+
+	// Reads until size bytes arrived or the stream timed out, like the AVR core
+	size_t readBytes(uint8_t* buffer, size_t length);
+	size_t readBytes(char* buffer, size_t length) { return readBytes((uint8_t*)buffer, length); }
+
+protected:
+	unsigned long _timeout;
+
+	int timedRead();
+};
@@ -0,0 +1,37 @@
+// Host USB CDC serial port. Input is injected by the harness, output is
+// buffered for it to collect.
+#pragma once
+
+#include "Stream.h"
+
+// Endpoints of the 32U4 core: CDC takes the first ones, PluggableUSB modules
+// get the rest in the order they were plugged
+#define USB_EP_SIZE 64
+#define CDC_FIRST_ENDPOINT 1
+#define CDC_ENPOINT_COUNT 3
+
+// Free bytes in the IN bank of ep, 0 while the host hasn't collected it
+int USB_SendSpace(uint8_t ep);
+
+class Serial_ : public Stream
+{
+public:
+	void begin(unsigned long baud) { (void)baud; }
+	void end(void) {}
+
+	virtual int available(void);
+	virtual int read(void);
+	virtual int peek(void);
+	virtual size_t write(uint8_t c);
+	virtual size_t write(const uint8_t* buffer, size_t size);
+	void flush(void) {}
+
+	// Output is buffered for the harness, writes never wait
+	int availableForWrite(void) { return USB_EP_SIZE; }
+
+	using Print::write;
+
+	operator bool() { return true; }
+};
+
+extern Serial_ Serial;
@@ -0,0 +1,69 @@
+// Host String: a thin wrapper over std::string with the Arduino constructors
+// and concatenation operators the firmware relies on.
+#pragma once
+
+#include <string>
+
+class String
+{
+public:
+	String(const char* cstr = "") : _str(cstr ? cstr : "") {}
+	String(const std::string& str) : _str(str) {}
+	String(char c) : _str(1, c) {}
+	String(unsigned char value, unsigned char base = 10) : _str(toBase(value, base)) {}
+	String(int value, unsigned char base = 10) : _str(toSigned(value, base)) {}
+	String(unsigned int value, unsigned char base = 10) : _str(toBase(value, base)) {}
+	String(long value, unsigned char base = 10) : _str(toSigned(value, base)) {}
+	String(unsigned long value, unsigned char base = 10) : _str(toBase(value, base)) {}
+	String(double value, unsigned char decimals = 2)
+	{
+		char buf[48];
+
+		snprintf(buf, sizeof(buf), "%.*f", decimals, value);
+		_str = buf;
+	}
+
+	const char* c_str() const { return _str.c_str(); }
+	unsigned int length() const { return _str.length(); }
+
+	String& operator+=(const String& rhs)
+	{
+		_str += rhs._str;
+		return *this;
+	}
+
+	bool operator==(const String& rhs) const { return _str == rhs._str; }
+	bool operator!=(const String& rhs) const { return _str != rhs._str; }
+
+	friend String operator+(const String& lhs, const String& rhs) { return String(lhs._str + rhs._str); }
+	friend String operator+(const char* lhs, const String& rhs) { return String(std::string(lhs) + rhs._str); }
+	friend String operator+(const String& lhs, const char* rhs) { return String(lhs._str + rhs); }
+
+private:
+	std::string _str;
+
+	static std::string toBase(unsigned long value, unsigned char base)
+	{
+		static const char digits[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+		std::string out;
+
+		if (base < 2 || base > 36)
+			base = 10;
+
+		do
+		{
+			out.insert(out.begin(), digits[value % base]);
+			value /= base;
+		} while (value);
+
+		return out;
+	}
+
+	static std::string toSigned(long value, unsigned char base)
+	{
+		if (value < 0 && base == 10)
+			return "-" + toBase((unsigned long)(-value), base);
+
+		return toBase((unsigned long)value, base);
+	}
+};
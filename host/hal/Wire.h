@@ -0,0 +1,63 @@
+// Host TwoWire. Master transactions go to the HalI2cBus model, slave writes
+// from the bus arrive through halI2cSlaveWrite() as interrupts.
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "Stream.h"
+
+#define BUFFER_LENGTH 32
+
+class TwoWire : public Stream
+{
+public:
+	TwoWire();
+
+	void begin();
+	void begin(uint8_t address);
+	void begin(int address) { begin((uint8_t)address); }
+	void end();
+	void setClock(uint32_t clock);
+
+	void beginTransmission(uint8_t address);
+	void beginTransmission(int address) { beginTransmission((uint8_t)address); }
+	uint8_t endTransmission(void) { return endTransmission(true); }
+	uint8_t endTransmission(uint8_t sendStop);
+
+	uint8_t requestFrom(uint8_t address, uint8_t quantity);
+	uint8_t requestFrom(int address, int quantity) { return requestFrom((uint8_t)address, (uint8_t)quantity); }
+
+	virtual size_t write(uint8_t data);
+	virtual size_t write(const uint8_t* data, size_t quantity);
+	virtual int available(void);
+	virtual int read(void);
+	virtual int peek(void);
+
+	using Print::write;
+
+	void onReceive(void (*function)(int));
+	void onRequest(void (*function)(void));
+
+	// HAL side
+	bool listeningOn(uint8_t address) const;
+	void slaveReceive(const uint8_t* data, size_t len);
+
+private:
+	uint8_t _slaveAddr;
+	bool _slaveEnabled;
+
+	uint8_t _rxBuffer[BUFFER_LENGTH];
+	uint8_t _rxIndex;
+	uint8_t _rxLength;
+
+	uint8_t _txAddress;
+	uint8_t _txBuffer[BUFFER_LENGTH];
+	uint8_t _txLength;
+	bool _transmitting;
+
+	void (*_onReceive)(int);
+	void (*_onRequest)(void);
+};
+
+extern TwoWire Wire;
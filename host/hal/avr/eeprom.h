@@ -0,0 +1,14 @@
+// Host avr-libc EEPROM primitives, addresses are offsets into the emulated array.
+#pragma once
+
+#include <stdint.h>
+
+#ifndef E2END
+#define E2END 0x3FF
+#endif
+
+int eeprom_is_ready(void);
+void eeprom_busy_wait(void);
+uint8_t eeprom_read_byte(const uint8_t* addr);
+void eeprom_write_byte(uint8_t* addr, uint8_t val);
+void eeprom_update_byte(uint8_t* addr, uint8_t val);
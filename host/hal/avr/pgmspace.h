@@ -0,0 +1,23 @@
+// Host flash access: program memory is ordinary memory on the host.
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#define PROGMEM
+#define PGM_P const char*
+#define PSTR(s) (s)
+#define F(s) (s)
+
+static inline uint8_t pgm_read_byte(const void* addr) { return *(const uint8_t*)addr; }
+static inline uint16_t pgm_read_word(const void* addr) { return *(const uint16_t*)addr; }
+static inline uint32_t pgm_read_dword(const void* addr) { return *(const uint32_t*)addr; }
+static inline float pgm_read_float(const void* addr) { return *(const float*)addr; }
+static inline void* pgm_read_ptr(const void* addr) { return *(void* const*)addr; }
+
+#define memcpy_P memcpy
+#define strlen_P strlen
+#define strcmp_P strcmp
+#define strncmp_P strncmp
+#define strcpy_P strcpy
+#define strncpy_P strncpy
@@ -0,0 +1,96 @@
+// EEPROM of the host HAL, with AVR programming latency and wear counters.
+#include <vector>
+
+#include "Arduino.h"
+#include "EEPROM.h"
+
+EEPROMClass EEPROM;
+
+#define HAL_EEPROM_SIZE (E2END + 1)
+
+static uint8_t eepromData[HAL_EEPROM_SIZE];
+static uint32_t eepromWrites[HAL_EEPROM_SIZE];
+static uint32_t eepromTotalWrites = 0;
+static uint32_t eepromWriteUs = 3400;
+static uint32_t eepromBusyUntil = 0;
+
+void halResetEeprom(void)
+{
+	memset(eepromData, 0xff, sizeof(eepromData));
+	memset(eepromWrites, 0, sizeof(eepromWrites));
+	eepromTotalWrites = 0;
+	eepromBusyUntil = 0;
+}
+
+uint8_t* halEepromData(void)
+{
+	return eepromData;
+}
+
+size_t halEepromSize(void)
+{
+	return HAL_EEPROM_SIZE;
+}
+
+uint32_t halEepromCellWrites(size_t addr)
+{
+	return (addr < HAL_EEPROM_SIZE) ? eepromWrites[addr] : 0;
+}
+
+uint32_t halEepromTotalWrites(void)
+{
+	return eepromTotalWrites;
+}
+
+void halSetEepromWriteMicros(uint32_t us)
+{
+	eepromWriteUs = us;
+}
+
+int eeprom_is_ready(void)
+{
+	return (int32_t)(halMicros() - eepromBusyUntil) >= 0;
+}
+
+void eeprom_busy_wait(void)
+{
+	if (!eeprom_is_ready())
+	{
+		halAdvanceMicros(eepromBusyUntil - halMicros());
+	}
+}
+
+uint8_t eeprom_read_byte(const uint8_t* addr)
+{
+	size_t idx = (size_t)(uintptr_t)addr;
+
+	eeprom_busy_wait();
+
+	return (idx < HAL_EEPROM_SIZE) ? eepromData[idx] : 0xff;
+}
+
+void eeprom_write_byte(uint8_t* addr, uint8_t val)
+{
+	size_t idx = (size_t)(uintptr_t)addr;
+
+	eeprom_busy_wait();
+
+	if (idx >= HAL_EEPROM_SIZE)
+	{
+		return;
+	}
+
+	// Programming runs in the background, the next access waits for it
+	eepromData[idx] = val;
+	eepromWrites[idx]++;
+	eepromTotalWrites++;
+	eepromBusyUntil = halMicros() + eepromWriteUs;
+}
+
+void eeprom_update_byte(uint8_t* addr, uint8_t val)
+{
+	if (eeprom_read_byte(addr) != val)
+	{
+		eeprom_write_byte(addr, val);
+	}
+}
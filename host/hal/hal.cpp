@@ -0,0 +1,318 @@
+// Virtual clock, event queue, interrupt gating and GPIO of the host HAL.
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "Arduino.h"
+#include "SPI.h"
+
+SPIClass SPI;
+
+struct hal_event_s
+{
+	hal_event_fn fn;
+	void* ctx;
+	bool isInterrupt;
+};
+
+// Ordered by (time, sequence) so equal-time events keep scheduling order
+typedef std::map<std::pair<uint32_t, uint64_t>, struct hal_event_s> hal_event_queue;
+
+static uint32_t clockUs = 0;
+static uint32_t callCostUs = 1;
+static uint64_t eventSeq = 0;
+static hal_event_queue events;
+static std::vector<struct hal_event_s> deferred;
+static bool dispatching = false;
+
+static bool irqEnabled = true;
+static uint32_t irqOffSinceUs = 0;
+static uint32_t irqOffMaxUs = 0;
+static uint32_t irqDeferredCnt = 0;
+
+static uint8_t pinOutputs[NUM_DIGITAL_PINS];
+static uint8_t pinInputs[NUM_DIGITAL_PINS];
+static HalPinListener* pinListener = NULL;
+
+void halResetSerial(void);
+void halResetWire(void);
+void halResetEeprom(void);
+void halResetHid(void);
+
+static void runEvent(const struct hal_event_s& ev)
+{
+	if (ev.isInterrupt && !irqEnabled)
+	{
+		irqDeferredCnt++;
+		deferred.push_back(ev);
+
+		return;
+	}
+
+	if (ev.isInterrupt)
+	{
+		// Like hardware, the handler runs with interrupts masked
+		irqEnabled = false;
+		irqOffSinceUs = clockUs;
+
+		ev.fn(ev.ctx);
+
+		irqEnabled = true;
+	}
+	else
+	{
+		ev.fn(ev.ctx);
+	}
+}
+
+static void dispatchUntil(uint32_t targetUs)
+{
+	if (dispatching)
+	{
+		clockUs = targetUs;
+
+		return;
+	}
+
+	dispatching = true;
+
+	while (!events.empty())
+	{
+		hal_event_queue::iterator it = events.begin();
+
+		if ((int32_t)(it->first.first - targetUs) > 0)
+		{
+			break;
+		}
+
+		uint32_t atUs = it->first.first;
+		struct hal_event_s ev = it->second;
+
+		events.erase(it);
+
+		if ((int32_t)(atUs - clockUs) > 0)
+		{
+			clockUs = atUs;
+		}
+
+		runEvent(ev);
+	}
+
+	if ((int32_t)(targetUs - clockUs) > 0)
+	{
+		clockUs = targetUs;
+	}
+
+	dispatching = false;
+}
+
+uint32_t halMicros(void)
+{
+	return clockUs;
+}
+
+void halAdvanceMicros(uint32_t us)
+{
+	dispatchUntil(clockUs + us);
+}
+
+void halSetCallCostMicros(uint32_t us)
+{
+	callCostUs = us;
+}
+
+void halScheduleEvent(uint32_t atUs, hal_event_fn fn, void* ctx)
+{
+	struct hal_event_s ev = { fn, ctx, false };
+
+	events[std::make_pair(atUs, eventSeq++)] = ev;
+}
+
+void halScheduleInterrupt(uint32_t atUs, hal_event_fn fn, void* ctx)
+{
+	struct hal_event_s ev = { fn, ctx, true };
+
+	events[std::make_pair(atUs, eventSeq++)] = ev;
+}
+
+bool halInterruptsEnabled(void)
+{
+	return irqEnabled;
+}
+
+uint32_t halMaxInterruptsOffMicros(void)
+{
+	return irqOffMaxUs;
+}
+
+uint32_t halDeferredInterrupts(void)
+{
+	return irqDeferredCnt;
+}
+
+void halReset(void)
+{
+	clockUs = 0;
+	eventSeq = 0;
+	events.clear();
+	deferred.clear();
+	dispatching = false;
+
+	irqEnabled = true;
+	irqOffSinceUs = 0;
+	irqOffMaxUs = 0;
+	irqDeferredCnt = 0;
+
+	memset(pinOutputs, LOW, sizeof(pinOutputs));
+	memset(pinInputs, LOW, sizeof(pinInputs));
+	pinListener = NULL;
+
+	halResetSerial();
+	halResetWire();
+	halResetEeprom();
+	halResetHid();
+	halSetLedListener(NULL);
+}
+
+// ***** Arduino core *****
+unsigned long micros(void)
+{
+	halAdvanceMicros(callCostUs);
+
+	return clockUs;
+}
+
+unsigned long millis(void)
+{
+	halAdvanceMicros(callCostUs);
+
+	return clockUs / 1000;
+}
+
+void delay(unsigned long ms)
+{
+	halAdvanceMicros(ms * 1000);
+}
+
+void delayMicroseconds(unsigned int us)
+{
+	halAdvanceMicros(us);
+}
+
+void yield(void)
+{
+	halAdvanceMicros(callCostUs);
+}
+
+void noInterrupts(void)
+{
+	if (irqEnabled)
+	{
+		irqOffSinceUs = clockUs;
+	}
+
+	irqEnabled = false;
+}
+
+void interrupts(void)
+{
+	if (irqEnabled)
+	{
+		return;
+	}
+
+	if (clockUs - irqOffSinceUs > irqOffMaxUs)
+	{
+		irqOffMaxUs = clockUs - irqOffSinceUs;
+	}
+
+	irqEnabled = true;
+
+	// Deliver whatever fired while masked, in arrival order
+	while (!deferred.empty() && irqEnabled)
+	{
+		struct hal_event_s ev = deferred.front();
+
+		deferred.erase(deferred.begin());
+
+		runEvent(ev);
+	}
+}
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+	(void)pin;
+	(void)mode;
+}
+
+void digitalWrite(uint8_t pin, uint8_t val)
+{
+	if (pin >= NUM_DIGITAL_PINS)
+	{
+		return;
+	}
+
+	halAdvanceMicros(callCostUs);
+
+	pinOutputs[pin] = val ? HIGH : LOW;
+
+	if (pinListener)
+	{
+		pinListener->onPinWrite(pin, pinOutputs[pin]);
+	}
+}
+
+int digitalRead(uint8_t pin)
+{
+	if (pin >= NUM_DIGITAL_PINS)
+	{
+		return LOW;
+	}
+
+	halAdvanceMicros(callCostUs);
+
+	return pinInputs[pin];
+}
+
+void halSetPinListener(HalPinListener* listener)
+{
+	pinListener = listener;
+}
+
+void halSetPinInput(uint8_t pin, uint8_t val)
+{
+	if (pin < NUM_DIGITAL_PINS)
+	{
+		pinInputs[pin] = val ? HIGH : LOW;
+	}
+}
+
+uint8_t halPinOutput(uint8_t pin)
+{
+	return (pin < NUM_DIGITAL_PINS) ? pinOutputs[pin] : LOW;
+}
+
+long random(long howbig)
+{
+	if (howbig == 0)
+	{
+		return 0;
+	}
+
+	return rand() % howbig;
+}
+
+long random(long howsmall, long howbig)
+{
+	if (howsmall >= howbig)
+	{
+		return howsmall;
+	}
+
+	return random(howbig - howsmall) + howsmall;
+}
+
+void randomSeed(unsigned long seed)
+{
+	srand(seed);
+}
@@ -0,0 +1,86 @@
+// USB HID of the host HAL. The keyboard endpoint holds one report, which the
+// host collects at the next 1 ms full-speed frame; SendReport blocks while
+// the bank is still full, like USB_Send on the 32U4.
+#include "Arduino.h"
+#include "HID.h"
+
+#define USB_FRAME_US 1000
+
+static HalHidListener* hidListener = NULL;
+static uint32_t hidReports = 0;
+static uint32_t hidBankFreeAt = 0;
+
+void halResetHid(void)
+{
+	hidListener = NULL;
+	hidReports = 0;
+	hidBankFreeAt = 0;
+}
+
+void halSetHidListener(HalHidListener* listener)
+{
+	hidListener = listener;
+}
+
+uint32_t halHidReports(void)
+{
+	return hidReports;
+}
+
+HID_& HID()
+{
+	static HID_ obj;
+
+	return obj;
+}
+
+void HID_::AppendDescriptor(HIDSubDescriptor* node)
+{
+	node->next = rootNode;
+	rootNode = node;
+}
+
+// Only the keyboard's bank is modelled, CDC endpoints never fill up
+int USB_SendSpace(uint8_t ep)
+{
+	if (ep < CDC_FIRST_ENDPOINT + CDC_ENPOINT_COUNT)
+	{
+		return USB_EP_SIZE;
+	}
+
+	return ((int32_t)(hidBankFreeAt - halMicros()) > 0) ? 0 : USB_EP_SIZE;
+}
+
+int HID_::SendReport(uint8_t id, const void* data, int len)
+{
+	uint8_t report[1 + 64];
+	uint32_t queued;
+	uint32_t delivered;
+
+	if ((len < 0) || (len > 64))
+	{
+		return -1;
+	}
+
+	// Wait for the previous report to be collected
+	if ((int32_t)(hidBankFreeAt - halMicros()) > 0)
+	{
+		halAdvanceMicros(hidBankFreeAt - halMicros());
+	}
+
+	queued = halMicros();
+	delivered = (queued / USB_FRAME_US + 1) * USB_FRAME_US;
+	hidBankFreeAt = delivered;
+
+	report[0] = id;
+	memcpy(report + 1, data, len);
+
+	hidReports++;
+
+	if (hidListener)
+	{
+		hidListener->onReport(id, report + 1, len, queued, delivered);
+	}
+
+	return len + 1;
+}
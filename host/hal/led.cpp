@@ -0,0 +1,17 @@
+// LED output capture of the host HAL.
+#include "Arduino.h"
+
+static HalLedListener* ledListener = NULL;
+
+void halSetLedListener(HalLedListener* listener)
+{
+	ledListener = listener;
+}
+
+void halLedShow(const uint8_t* data, size_t len, uint32_t startUs, uint32_t endUs)
+{
+	if (ledListener)
+	{
+		ledListener->onShow(data, len, startUs, endUs);
+	}
+}
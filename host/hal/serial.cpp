@@ -0,0 +1,127 @@
+// USB CDC serial and Stream helpers of the host HAL.
+#include <deque>
+
+#include "Arduino.h"
+
+Serial_ Serial;
+
+static std::deque<uint8_t> serialIn;
+static std::deque<uint8_t> serialOut;
+static bool serialEcho = false;
+
+void halResetSerial(void)
+{
+	serialIn.clear();
+	serialOut.clear();
+}
+
+void halSerialInject(const uint8_t* data, size_t len)
+{
+	serialIn.insert(serialIn.end(), data, data + len);
+}
+
+size_t halSerialOutputAvailable(void)
+{
+	return serialOut.size();
+}
+
+size_t halSerialTakeOutput(uint8_t* buf, size_t len)
+{
+	size_t n = 0;
+
+	while ((n < len) && !serialOut.empty())
+	{
+		buf[n++] = serialOut.front();
+		serialOut.pop_front();
+	}
+
+	return n;
+}
+
+void halSerialSetEcho(bool echo)
+{
+	serialEcho = echo;
+}
+
+int Serial_::available(void)
+{
+	yield();
+
+	return serialIn.size();
+}
+
+int Serial_::read(void)
+{
+	if (serialIn.empty())
+	{
+		return -1;
+	}
+
+	int c = serialIn.front();
+
+	serialIn.pop_front();
+
+	return c;
+}
+
+int Serial_::peek(void)
+{
+	return serialIn.empty() ? -1 : serialIn.front();
+}
+
+size_t Serial_::write(uint8_t c)
+{
+	serialOut.push_back(c);
+
+	if (serialEcho)
+	{
+		fputc(c, stdout);
+	}
+
+	return 1;
+}
+
+size_t Serial_::write(const uint8_t* buffer, size_t size)
+{
+	for (size_t i = 0; i < size; ++i)
+	{
+		write(buffer[i]);
+	}
+
+	return size;
+}
+
+int Stream::timedRead()
+{
+	unsigned long start = millis();
+
+	do
+	{
+		if (available())
+		{
+			return read();
+		}
+	} while (millis() - start < _timeout);
+
+	return -1;
+}
+
+size_t Stream::readBytes(uint8_t* buffer, size_t length)
+{
+	size_t count = 0;
+
+	while (count < length)
+	{
+		int c = timedRead();
+
+		if (c < 0)
+		{
+			break;
+		}
+
+		*buffer++ = (uint8_t)c;
+		count++;
+	}
+
+	return count;
+}
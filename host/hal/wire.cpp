@@ -0,0 +1,246 @@
+// I2C of the host HAL. Master transactions are charged their bus time at the
+// configured clock; slave writes are delivered through the interrupt queue.
+#include <vector>
+
+#include "Arduino.h"
+#include "Wire.h"
+
+TwoWire Wire;
+
+static HalI2cBus* i2cBus = NULL;
+static uint32_t i2cClockHz = 100000;
+static uint32_t i2cSlaveDropped = 0;
+
+struct slave_write_s
+{
+	uint8_t addr;
+	std::vector<uint8_t> data;
+};
+
+void halResetWire(void)
+{
+	i2cBus = NULL;
+	i2cClockHz = 100000;
+	i2cSlaveDropped = 0;
+	Wire = TwoWire();
+}
+
+void halSetI2cBus(HalI2cBus* bus)
+{
+	i2cBus = bus;
+}
+
+void halSetI2cClock(uint32_t hz)
+{
+	i2cClockHz = hz;
+}
+
+uint32_t halI2cByteMicros(void)
+{
+	// 8 data bits and the ACK bit
+	return (9UL * 1000000UL + i2cClockHz - 1) / i2cClockHz;
+}
+
+static void deliverSlaveWrite(void* ctx)
+{
+	struct slave_write_s* w = (struct slave_write_s*)ctx;
+
+	if (Wire.listeningOn(w->addr))
+	{
+		Wire.slaveReceive(w->data.data(), w->data.size());
+	}
+	else
+	{
+		i2cSlaveDropped++;
+	}
+
+	delete w;
+}
+
+void halI2cSlaveWrite(uint32_t atUs, uint8_t addr, const uint8_t* data, size_t len)
+{
+	struct slave_write_s* w = new slave_write_s;
+
+	w->addr = addr;
+	w->data.assign(data, data + len);
+
+	// The receive interrupt fires once the address and payload are clocked in
+	halScheduleInterrupt(atUs + halI2cByteMicros() * (len + 1), deliverSlaveWrite, w);
+}
+
+uint32_t halI2cSlaveWritesDropped(void)
+{
+	return i2cSlaveDropped;
+}
+
+TwoWire::TwoWire() :
+	_slaveAddr(0),
+	_slaveEnabled(false),
+	_rxIndex(0),
+	_rxLength(0),
+	_txAddress(0),
+	_txLength(0),
+	_transmitting(false),
+	_onReceive(NULL),
+	_onRequest(NULL)
+{
+}
+
+void TwoWire::begin()
+{
+	_slaveEnabled = false;
+	_rxIndex = _rxLength = 0;
+	_txLength = 0;
+}
+
+void TwoWire::begin(uint8_t address)
+{
+	begin();
+
+	_slaveAddr = address;
+	_slaveEnabled = true;
+}
+
+void TwoWire::end()
+{
+	_slaveEnabled = false;
+}
+
+void TwoWire::setClock(uint32_t clock)
+{
+	halSetI2cClock(clock);
+}
+
+void TwoWire::beginTransmission(uint8_t address)
+{
+	_transmitting = true;
+	_txAddress = address;
+	_txLength = 0;
+}
+
+uint8_t TwoWire::endTransmission(uint8_t sendStop)
+{
+	bool ack = false;
+
+	(void)sendStop;
+
+	// Bus time for address and payload, the TWI ISR keeps interrupts enabled
+	halAdvanceMicros(halI2cByteMicros() * (_txLength + 1));
+
+	if (i2cBus)
+	{
+		ack = i2cBus->masterWrite(_txAddress, _txBuffer, _txLength);
+	}
+
+	_transmitting = false;
+	_txLength = 0;
+
+	// 2: NACK on address, like the AVR core
+	return ack ? 0 : 2;
+}
+
+uint8_t TwoWire::requestFrom(uint8_t address, uint8_t quantity)
+{
+	size_t got = 0;
+
+	if (quantity > BUFFER_LENGTH)
+	{
+		quantity = BUFFER_LENGTH;
+	}
+
+	if (i2cBus)
+	{
+		got = i2cBus->masterRead(address, _rxBuffer, quantity);
+	}
+
+	halAdvanceMicros(halI2cByteMicros() * (got + 1));
+
+	_rxIndex = 0;
+	_rxLength = got;
+
+	return got;
+}
+
+size_t TwoWire::write(uint8_t data)
+{
+	if (_txLength >= BUFFER_LENGTH)
+	{
+		setWriteError();
+
+		return 0;
+	}
+
+	_txBuffer[_txLength++] = data;
+
+	return 1;
+}
+
+size_t TwoWire::write(const uint8_t* data, size_t quantity)
+{
+	for (size_t i = 0; i < quantity; ++i)
+	{
+		if (!write(data[i]))
+		{
+			return i;
+		}
+	}
+
+	return quantity;
+}
+
+int TwoWire::available(void)
+{
+	return _rxLength - _rxIndex;
+}
+
+int TwoWire::read(void)
+{
+	if (_rxIndex >= _rxLength)
+	{
+		return -1;
+	}
+
+	return _rxBuffer[_rxIndex++];
+}
+
+int TwoWire::peek(void)
+{
+	if (_rxIndex >= _rxLength)
+	{
+		return -1;
+	}
+
+	return _rxBuffer[_rxIndex];
+}
+
+void TwoWire::onReceive(void (*function)(int))
+{
+	_onReceive = function;
+}
+
+void TwoWire::onRequest(void (*function)(void))
+{
+	_onRequest = function;
+}
+
+bool TwoWire::listeningOn(uint8_t address) const
+{
+	return _slaveEnabled && (_slaveAddr == address);
+}
+
+void TwoWire::slaveReceive(const uint8_t* data, size_t len)
+{
+	if (len > BUFFER_LENGTH)
+	{
+		len = BUFFER_LENGTH;
+	}
+
+	memcpy(_rxBuffer, data, len);
+	_rxIndex = 0;
+	_rxLength = len;
+
+	if (_onReceive)
+	{
+		_onReceive(len);
+	}
+}
@@ -0,0 +1,279 @@
+// Checks NeoBitPlanes and the parallel (multi-lane) NeoPixelBus methods.
+//
+//   paws-lanes [--matrices N] [--seed N]
+//
+// Transpose8 is checked bit by bit against a plain loop on every single bit
+// matrix and N random ones, and FromLanes/ToLanes round trip for every lane
+// count and first port bit, the shifting FromLanes<V_LANES> giving the same
+// planes as the transposing one. Then each NeoHostX*Ws2812xMethod bus is
+// shown random pixels for several strip lengths; the lanes recovered from the
+// planes it sent must match the pixels, and the frame time is reported
+// against one lane's wire time, which is what it would take if building the
+// planes cost nothing. Last, the host speed of FromLanes<V_LANES> is printed.
+//
+// The exit status is 1 on any mismatch.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+
+#include <NeoPixelBus.h>
+
+static const uint16_t stripLengths[] = { 1, 7, 64, 128, 301 };
+
+class FrameLog : public HalLedListener
+{
+public:
+	std::vector<uint8_t> data;
+	uint32_t startUs;
+	uint32_t endUs;
+
+	void onShow(const uint8_t* frame, size_t len, uint32_t start, uint32_t end)
+	{
+		data.assign(frame, frame + len);
+		startUs = start;
+		endUs = end;
+	}
+};
+
+static double wallSeconds()
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// planes[p] bit n is bit (7 - p) of rows[7 - n]
+static bool transposeOk(const uint8_t* rows)
+{
+	uint8_t planes[8];
+
+	memcpy(planes, rows, 8);
+	NeoBitPlanes::Transpose8(planes);
+
+	for (int p = 0; p < 8; ++p)
+	{
+		for (int n = 0; n < 8; ++n)
+		{
+			if (((planes[p] >> n) & 1) != ((rows[7 - n] >> (7 - p)) & 1))
+				return false;
+		}
+	}
+
+	// its own inverse
+	NeoBitPlanes::Transpose8(planes);
+
+	return !memcmp(planes, rows, 8);
+}
+
+static unsigned checkTranspose(unsigned long matrices)
+{
+	unsigned bad = 0;
+	uint8_t rows[8];
+
+	for (int bit = 0; bit < 64; ++bit)
+	{
+		memset(rows, 0, sizeof(rows));
+		rows[bit / 8] = 1 << (bit % 8);
+
+		if (!transposeOk(rows))
+			bad++;
+	}
+
+	for (unsigned long m = 0; m < matrices; ++m)
+	{
+		for (int r = 0; r < 8; ++r)
+			rows[r] = rand() & 0xff;
+
+		if (!transposeOk(rows))
+			bad++;
+	}
+
+	printf("transpose: %lu matrices, %u bad\n", matrices + 64, bad);
+
+	return bad;
+}
+
+static void fromLanes(uint8_t lanes, const uint8_t* data, size_t laneSize, uint8_t firstBit, uint8_t* planes)
+{
+	switch (lanes)
+	{
+	case 1: NeoBitPlanes::FromLanes<1>(data, laneSize, firstBit, 0, laneSize, planes); break;
+	case 2: NeoBitPlanes::FromLanes<2>(data, laneSize, firstBit, 0, laneSize, planes); break;
+	case 3: NeoBitPlanes::FromLanes<3>(data, laneSize, firstBit, 0, laneSize, planes); break;
+	case 4: NeoBitPlanes::FromLanes<4>(data, laneSize, firstBit, 0, laneSize, planes); break;
+	case 5: NeoBitPlanes::FromLanes<5>(data, laneSize, firstBit, 0, laneSize, planes); break;
+	case 6: NeoBitPlanes::FromLanes<6>(data, laneSize, firstBit, 0, laneSize, planes); break;
+	case 7: NeoBitPlanes::FromLanes<7>(data, laneSize, firstBit, 0, laneSize, planes); break;
+	default: NeoBitPlanes::FromLanes<8>(data, laneSize, firstBit, 0, laneSize, planes); break;
+	}
+}
+
+static unsigned checkRoundTrip()
+{
+	const size_t laneSize = 12;
+	unsigned bad = 0;
+
+	for (uint8_t lanes = 1; lanes <= 8; ++lanes)
+	{
+		for (uint8_t firstBit = 0; firstBit + lanes <= 8; ++firstBit)
+		{
+			std::vector<uint8_t> data(laneSize * lanes);
+			std::vector<uint8_t> back(data.size());
+			std::vector<uint8_t> planes(laneSize * 8);
+			std::vector<uint8_t> shifted(planes.size());
+			uint8_t mask = ((1 << lanes) - 1) << firstBit;
+
+			for (size_t i = 0; i < data.size(); ++i)
+				data[i] = rand() & 0xff;
+
+			NeoBitPlanes::FromLanes(data.data(), laneSize, lanes, firstBit, 0, laneSize, planes.data());
+			NeoBitPlanes::ToLanes(planes.data(), laneSize, lanes, firstBit, 0, laneSize, back.data());
+
+			if (back != data)
+				bad++;
+
+			fromLanes(lanes, data.data(), laneSize, firstBit, shifted.data());
+
+			if (shifted != planes)
+				bad++;
+
+			// nothing outside the lanes' port bits
+			for (size_t p = 0; p < planes.size(); ++p)
+			{
+				if (planes[p] & ~mask)
+				{
+					bad++;
+
+					break;
+				}
+			}
+		}
+	}
+
+	printf("lanes round trip: %u bad\n", bad);
+
+	return bad;
+}
+
+template<typename T_METHOD> static unsigned checkBus(uint8_t lanes)
+{
+	unsigned bad = 0;
+
+	for (size_t s = 0; s < sizeof(stripLengths) / sizeof(stripLengths[0]); ++s)
+	{
+		uint16_t count = stripLengths[s];
+		NeoPixelBus<NeoGrbFeature, T_METHOD> bus(count, 0);
+		FrameLog log;
+		std::vector<uint8_t> expected;
+		size_t laneSize = ((count + lanes - 1) / lanes) * NeoGrbFeature::PixelSize;
+
+		halSetLedListener(&log);
+
+		bus.Begin();
+
+		for (uint16_t i = 0; i < count; ++i)
+			bus.SetPixelColor(i, RgbColor(rand() & 0xff, rand() & 0xff, rand() & 0xff));
+
+		bus.Show();
+
+		halSetLedListener(NULL);
+
+		expected.assign(bus.Pixels(), bus.Pixels() + bus.PixelsSize());
+		expected.resize(laneSize * lanes, 0);
+
+		bool ok = (log.data == expected);
+
+		if (!ok)
+			bad++;
+
+		uint32_t frameUs = log.endUs - log.startUs;
+		uint32_t laneUs = NeoHostSpeedWs2812x::FrameTimeUs(laneSize);
+
+		printf("  x%u %4u pixels: frame %5u us, one lane %5u us (x%.2f), one strip %5u us, max gap %u us  %s\n",
+			lanes, count, frameUs, laneUs, (double)frameUs / laneUs,
+			NeoHostSpeedWs2812x::FrameTimeUs(count * NeoGrbFeature::PixelSize),
+			bus.Method().MaxGapUs(), ok ? "ok" : "MISMATCH");
+	}
+
+	return bad;
+}
+
+template<uint8_t V_LANES> static void timePlanes()
+{
+	const size_t laneSize = 3 * 128;
+	const int rounds = 2000;
+	std::vector<uint8_t> data(laneSize * V_LANES);
+	uint8_t planes[8 * 3];
+	unsigned sink = 0;
+
+	for (size_t i = 0; i < data.size(); ++i)
+		data[i] = rand() & 0xff;
+
+	double start = wallSeconds();
+
+	for (int r = 0; r < rounds; ++r)
+	{
+		for (size_t offset = 0; offset < laneSize; offset += 3)
+		{
+			NeoBitPlanes::FromLanes<V_LANES>(data.data(), laneSize, 0, offset, 3, planes);
+			sink += planes[r % sizeof(planes)];
+		}
+	}
+
+	double seconds = wallSeconds() - start;
+
+	printf("planes (host): %.2f ns per pixel byte, %u lanes (%u)\n",
+		seconds * 1e9 / ((double)rounds * laneSize), V_LANES, sink & 1);
+}
+
+int main(int argc, char** argv)
+{
+	unsigned long matrices = 100000;
+	unsigned long seed = 1;
+	unsigned bad = 0;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (!strcmp(argv[i], "--matrices") && (i + 1 < argc))
+			matrices = strtoul(argv[++i], NULL, 0);
+		else if (!strcmp(argv[i], "--seed") && (i + 1 < argc))
+			seed = strtoul(argv[++i], NULL, 0);
+		else
+		{
+			fprintf(stderr, "usage: %s [--matrices N] [--seed N]\n", argv[0]);
+
+			return 1;
+		}
+	}
+
+	srand(seed);
+
+	bad += checkTranspose(matrices);
+	bad += checkRoundTrip();
+
+	halReset();
+
+	printf("buses:\n");
+	bad += checkBus<NeoHostX2Ws2812xMethod>(2);
+	bad += checkBus<NeoHostX4Ws2812xMethod>(4);
+	bad += checkBus<NeoHostX8Ws2812xMethod>(8);
+
+	timePlanes<2>();
+	timePlanes<4>();
+	timePlanes<8>();
+
+	return bad ? 1 : 0;
+}
+
+// The HAL expects a sketch
+void setup(void)
+{
+}
+
+void loop(void)
+{
+}
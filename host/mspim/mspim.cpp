@@ -0,0 +1,249 @@
+// Checks the NeoMspimEncoder waveform against WS2812-family timing specs.
+//
+//   paws-mspim [--part NAME] [--bytes N] [--seed N]
+//
+// Every byte value, then N random bytes, are encoded back to back into one
+// USART symbol stream as NeoAvrUsartMspimMethodBase sends it. The stream is
+// replayed as a line level per SPI bit at F_CPU / (2 * (UBRR + 1)), split
+// into high and low pulses, and decoded again. Every pulse is checked against
+// the datasheet limits of each part and the decoded bytes against the input.
+//
+// The exit status is 1 if decoding fails or any pulse is out of the limits
+// of --part (default ws2812b).
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include <NeoPixelBus.h>
+
+#define MSPIM_CPU_HZ 16000000UL
+
+// Datasheet nominal +-150 ns for every pulse, and the bit period limits
+struct ws_part_s
+{
+	const char* name;
+	uint16_t t0h;
+	uint16_t t1h;
+	uint16_t t0l;
+	uint16_t t1l;
+	uint16_t periodMin;
+	uint16_t periodMax;
+};
+
+#define WS_TOLERANCE_NS 150
+
+static const struct ws_part_s parts[] = {
+	{ "ws2812b", 400, 800, 850, 450, 650, 1850 },
+	{ "ws2812", 350, 700, 800, 600, 650, 1850 },
+	{ "sk6812", 300, 600, 900, 600, 1050, 1650 },
+};
+
+struct pulse_range_s
+{
+	uint32_t min;
+	uint32_t max;
+};
+
+// Shortest and longest of each pulse kind seen in the stream
+struct ws_waveform_s
+{
+	struct pulse_range_s t0h;
+	struct pulse_range_s t1h;
+	struct pulse_range_s t0l;
+	struct pulse_range_s t1l;
+	struct pulse_range_s period;
+	uint32_t bits;
+};
+
+static void rangeAdd(struct pulse_range_s* range, uint32_t ns)
+{
+	if ((range->min == 0) || (ns < range->min))
+		range->min = ns;
+
+	if (ns > range->max)
+		range->max = ns;
+}
+
+static bool rangeWithin(const struct pulse_range_s* range, uint32_t nominal)
+{
+	// Nothing of this kind was sent
+	if (range->max == 0)
+		return true;
+
+	return (range->min + WS_TOLERANCE_NS >= nominal) && (range->max <= nominal + WS_TOLERANCE_NS);
+}
+
+// Replays the symbol stream and decodes it, a bit is a high pulse then a low
+// pulse and is a one when the high pulse is the longer
+static bool decode(const std::vector<uint8_t>& symbols, uint32_t spiBitNs, std::vector<uint8_t>* out,
+	struct ws_waveform_s* wave)
+{
+	std::vector<uint8_t> level;
+	size_t i = 0;
+	uint8_t byte = 0;
+	uint8_t bitCount = 0;
+
+	for (size_t s = 0; s < symbols.size(); ++s)
+	{
+		for (int b = 7; b >= 0; --b)
+		{
+			level.push_back((symbols[s] >> b) & 1);
+		}
+	}
+
+	memset(wave, 0, sizeof(*wave));
+
+	while (i < level.size())
+	{
+		uint32_t high = 0;
+		uint32_t low = 0;
+
+		if (!level[i])
+		{
+			fprintf(stderr, "line low at SPI bit %zu where a WS bit should start\n", i);
+
+			return false;
+		}
+
+		while ((i < level.size()) && (level[i]))
+		{
+			high++;
+			i++;
+		}
+
+		while ((i < level.size()) && (!level[i]))
+		{
+			low++;
+			i++;
+		}
+
+		bool one = high > low;
+		uint32_t highNs = high * spiBitNs;
+		uint32_t lowNs = low * spiBitNs;
+
+		rangeAdd(one ? &wave->t1h : &wave->t0h, highNs);
+		rangeAdd(one ? &wave->t1l : &wave->t0l, lowNs);
+		rangeAdd(&wave->period, highNs + lowNs);
+		wave->bits++;
+
+		byte = (byte << 1) | (one ? 1 : 0);
+
+		if (++bitCount == 8)
+		{
+			out->push_back(byte);
+			bitCount = 0;
+		}
+	}
+
+	return bitCount == 0;
+}
+
+static bool partWithin(const struct ws_part_s* part, const struct ws_waveform_s* wave)
+{
+	return rangeWithin(&wave->t0h, part->t0h) && rangeWithin(&wave->t1h, part->t1h) &&
+		rangeWithin(&wave->t0l, part->t0l) && rangeWithin(&wave->t1l, part->t1l) &&
+		(wave->period.min >= part->periodMin) && (wave->period.max <= part->periodMax);
+}
+
+static void printRange(const char* name, const struct pulse_range_s* range, uint32_t nominal)
+{
+	printf("  %-6s %5u-%-5u ns  limits %u-%u  %s\n", name, range->min, range->max,
+		nominal - WS_TOLERANCE_NS, nominal + WS_TOLERANCE_NS, rangeWithin(range, nominal) ? "ok" : "OUT");
+}
+
+int main(int argc, char** argv)
+{
+	const char* partName = "ws2812b";
+	const struct ws_part_s* gate = NULL;
+	unsigned long count = 4096;
+	unsigned long seed = 1;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (!strcmp(argv[i], "--part") && (i + 1 < argc))
+			partName = argv[++i];
+		else if (!strcmp(argv[i], "--bytes") && (i + 1 < argc))
+			count = strtoul(argv[++i], NULL, 0);
+		else if (!strcmp(argv[i], "--seed") && (i + 1 < argc))
+			seed = strtoul(argv[++i], NULL, 0);
+		else
+		{
+			fprintf(stderr, "usage: %s [--part ws2812b|ws2812|sk6812] [--bytes N] [--seed N]\n", argv[0]);
+
+			return 1;
+		}
+	}
+
+	for (size_t p = 0; p < sizeof(parts) / sizeof(parts[0]); ++p)
+	{
+		if (!strcmp(parts[p].name, partName))
+			gate = &parts[p];
+	}
+
+	if (!gate)
+	{
+		fprintf(stderr, "unknown part %s\n", partName);
+
+		return 1;
+	}
+
+	std::vector<uint8_t> data;
+	std::vector<uint8_t> symbols;
+	std::vector<uint8_t> decoded;
+	struct ws_waveform_s wave;
+	// 1e9 * 2 * (UBRR + 1) / F_CPU, exact at 16 MHz
+	uint32_t spiBitNs = (uint32_t)(1000000000ULL * 2 * (NeoMspimEncoder::Ubrr16Mhz + 1) / MSPIM_CPU_HZ);
+
+	srand(seed);
+
+	for (unsigned v = 0; v < 256; ++v)
+		data.push_back(v);
+
+	for (unsigned long n = 0; n < count; ++n)
+		data.push_back(rand() & 0xff);
+
+	for (size_t n = 0; n < data.size(); ++n)
+	{
+		uint8_t out[NeoMspimEncoder::SymbolBytesPerByte];
+
+		NeoMspimEncoder::EncodeByte(data[n], out);
+		symbols.insert(symbols.end(), out, out + sizeof(out));
+	}
+
+	if (!decode(symbols, spiBitNs, &decoded, &wave) || (decoded != data))
+	{
+		printf("decode: FAILED, %zu bytes in, %zu out\n", data.size(), decoded.size());
+
+		return 1;
+	}
+
+	printf("decode: %zu bytes, %u bits ok\n", data.size(), wave.bits);
+	printf("SPI bit %u ns (UBRR %u at %lu Hz), %u SPI bits per WS bit\n", spiBitNs,
+		NeoMspimEncoder::Ubrr16Mhz, MSPIM_CPU_HZ, NeoMspimEncoder::SpiBitsPerBit);
+
+	for (size_t p = 0; p < sizeof(parts) / sizeof(parts[0]); ++p)
+	{
+		const struct ws_part_s* part = &parts[p];
+
+		printf("%s: %s\n", part->name, partWithin(part, &wave) ? "ok" : "OUT OF SPEC");
+		printRange("T0H", &wave.t0h, part->t0h);
+		printRange("T1H", &wave.t1h, part->t1h);
+		printRange("T0L", &wave.t0l, part->t0l);
+		printRange("T1L", &wave.t1l, part->t1l);
+		printf("  %-6s %5u-%-5u ns  limits %u-%u  %s\n", "period", wave.period.min, wave.period.max,
+			part->periodMin, part->periodMax,
+			((wave.period.min >= part->periodMin) && (wave.period.max <= part->periodMax)) ? "ok" : "OUT");
+	}
+
+	return partWithin(gate, &wave) ? 0 : 1;
+}
+
+// The HAL expects a sketch
+void setup(void)
+{
+}
+
+void loop(void)
+{
+}
@@ -0,0 +1,186 @@
+// Bulk pixel writes of NeoPixelBus against the per-pixel path, on the host.
+//
+//   paws-pixels [--pixels N] [--rounds N] [--json]
+//
+// A frame of N random colors is written into a NeoGrbFeature bus with:
+//   pixel     SetPixelColor() per pixel
+//   compare   GetPixelColor() and SetPixelColor() only on change, as the
+//             firmware's render loop did before RenderPixels
+//   span      SetPixelColors()
+//   span_P    SetPixelColors_P(), the colors in PROGMEM
+//   render    RenderPixels() with a callback returning the colors
+// Each must leave the same wire bytes. Times are host wall clock per pixel,
+// for comparison between the paths only; device numbers come from the
+// NeoPixelBulkWrite example.
+//
+// The exit status is 1 if any path leaves different bytes.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+
+#include <NeoPixelBus.h>
+
+typedef NeoPixelBus<NeoGrbFeature, NeoHostWs2812xMethod> bench_bus_t;
+
+struct frame_s
+{
+	const RgbColor* colors;
+	// alternate frames write the colors inverted, so every pixel changes
+	bool invert;
+};
+
+static double wallSeconds()
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static RgbColor frameColor(const struct frame_s* frame, uint16_t index)
+{
+	RgbColor color = frame->colors[index];
+
+	return frame->invert ? RgbColor(~color.R, ~color.G, ~color.B) : color;
+}
+
+static RgbColor renderPixel(void* context, uint16_t indexPixel)
+{
+	return frameColor(static_cast<const struct frame_s*>(context), indexPixel);
+}
+
+// Runs one path for rounds frames, alternating plain and inverted colors,
+// and returns the host ns per pixel
+static double runPath(const char* path, bench_bus_t& bus, const std::vector<RgbColor>& colors,
+	const std::vector<RgbColor>& inverted, unsigned long rounds)
+{
+	uint16_t count = bus.PixelCount();
+	double start = wallSeconds();
+
+	for (unsigned long r = 0; r < rounds; ++r)
+	{
+		struct frame_s frame = { colors.data(), (r & 1) != 0 };
+		const RgbColor* span = frame.invert ? inverted.data() : colors.data();
+
+		if (!strcmp(path, "pixel"))
+		{
+			for (uint16_t i = 0; i < count; ++i)
+				bus.SetPixelColor(i, frameColor(&frame, i));
+		}
+		else if (!strcmp(path, "compare"))
+		{
+			for (uint16_t i = 0; i < count; ++i)
+			{
+				RgbColor color = frameColor(&frame, i);
+
+				if (bus.GetPixelColor(i) != color)
+					bus.SetPixelColor(i, color);
+			}
+		}
+		else if (!strcmp(path, "span"))
+		{
+			bus.SetPixelColors(0, span, count);
+		}
+		else if (!strcmp(path, "span_P"))
+		{
+			// the host has no separate program memory
+			bus.SetPixelColors_P(0, span, count);
+		}
+		else
+		{
+			bus.RenderPixels(0, count, renderPixel, &frame);
+		}
+
+		bus.ResetDirty();
+	}
+
+	return (wallSeconds() - start) * 1e9 / ((double)rounds * count);
+}
+
+int main(int argc, char** argv)
+{
+	static const char* paths[] = { "pixel", "compare", "span", "span_P", "render" };
+	unsigned long pixels = 128;
+	unsigned long rounds = 20000;
+	bool json = false;
+	int status = 0;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (!strcmp(argv[i], "--pixels") && (i + 1 < argc))
+			pixels = strtoul(argv[++i], NULL, 0);
+		else if (!strcmp(argv[i], "--rounds") && (i + 1 < argc))
+			rounds = strtoul(argv[++i], NULL, 0) | 1;
+		else if (!strcmp(argv[i], "--json"))
+			json = true;
+		else
+		{
+			fprintf(stderr, "usage: %s [--pixels N] [--rounds N] [--json]\n", argv[0]);
+
+			return 1;
+		}
+	}
+
+	halReset();
+
+	std::vector<RgbColor> colors(pixels);
+	std::vector<RgbColor> inverted(pixels);
+	std::vector<uint8_t> reference;
+	double baseNs = 0;
+
+	srand(1);
+
+	for (unsigned long i = 0; i < pixels; ++i)
+	{
+		colors[i] = RgbColor(rand() & 0xff, rand() & 0xff, rand() & 0xff);
+		inverted[i] = RgbColor(~colors[i].R, ~colors[i].G, ~colors[i].B);
+	}
+
+	for (size_t p = 0; p < sizeof(paths) / sizeof(paths[0]); ++p)
+	{
+		bench_bus_t bus(pixels, 0);
+
+		bus.Begin();
+
+		// an odd number of rounds, so the last frame is the inverted one
+		double ns = runPath(paths[p], bus, colors, inverted, rounds);
+		std::vector<uint8_t> bytes(bus.Pixels(), bus.Pixels() + bus.PixelsSize());
+		bool same;
+
+		if (p == 0)
+		{
+			reference = bytes;
+			baseNs = ns;
+		}
+
+		same = (bytes == reference);
+
+		if (!same)
+			status = 1;
+
+		if (json)
+		{
+			printf("{\"path\":\"%s\",\"pixels\":%lu,\"ns_per_pixel\":%.2f,\"speedup\":%.2f,\"same\":%s}\n",
+				paths[p], pixels, ns, ns > 0 ? baseNs / ns : 0.0, same ? "true" : "false");
+		}
+		else
+		{
+			printf("%-8s %8.2f ns/pixel  x%.2f  %s\n", paths[p], ns, ns > 0 ? baseNs / ns : 0.0,
+				same ? "ok" : "DIFFERENT BYTES");
+		}
+	}
+
+	return status;
+}
+
+// The HAL expects a sketch
+void setup(void)
+{
+}
+
+void loop(void)
+{
+}
@@ -0,0 +1,191 @@
+// Host runner for the paws master firmware: boots it against a simulated
+// module chain and spins loop() on the virtual clock.
+//
+//   paws-host [--modules N] [--loops N] [--loop-cost-us N] [--hop-us N]
+//             [--hop-jitter-us N] [--nack-rate P] [--storm-gap-us N]
+//             [--storm-hold-us N] [--storm-ms N] [--echo]
+//
+// With --storm-gap-us, random modules are pressed that far apart on average
+// for --storm-ms after boot, loop() runs until the storm is over, and the
+// events the firmware missed are reported.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <Arduino.h>
+
+#include "../sim/ModuleChain.h"
+
+#define SERIAL_REQUEST_BEGIN 0x42
+#define SERIAL_SEND_EVENT_STATS 0x45
+
+struct event_stats_s
+{
+	uint16_t overflows;
+	uint16_t invalid;
+	uint8_t maxDepth;
+	uint32_t maxLatencyUs;
+};
+
+static double wallSeconds()
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Ask the firmware for its event queue stats over serial
+static bool queryEventStats(struct event_stats_s* stats)
+{
+	const uint8_t req[] = { SERIAL_REQUEST_BEGIN, SERIAL_SEND_EVENT_STATS, SERIAL_SEND_EVENT_STATS };
+	uint8_t buf[16];
+
+	while (halSerialTakeOutput(buf, sizeof(buf)))
+		;
+
+	halSerialInject(req, sizeof(req));
+
+	for (int i = 0; i < 100 && halSerialOutputAvailable() < 12; ++i)
+	{
+		loop();
+	}
+
+	// | "Bi" | overflows (2) | invalid addrs (2) | max queue depth (1) | max latency us (4) | 0xff |
+	if ((halSerialTakeOutput(buf, sizeof(buf)) != 12) || (buf[11] != 0xff))
+	{
+		return false;
+	}
+
+	memcpy(&stats->overflows, buf + 2, 2);
+	memcpy(&stats->invalid, buf + 4, 2);
+	stats->maxDepth = buf[6];
+	memcpy(&stats->maxLatencyUs, buf + 7, 4);
+
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	module_chain_config_s config = ModuleChain::defaultConfig();
+	unsigned long modules = 6;
+	unsigned long loops = 100000;
+	unsigned long loopCostUs = 0;
+	unsigned long stormGapUs = 0;
+	unsigned long stormHoldUs = 20000;
+	unsigned long stormMs = 1000;
+	uint32_t stormEndUs = 0;
+	bool echo = false;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (!strcmp(argv[i], "--modules") && (i + 1 < argc))
+			modules = strtoul(argv[++i], NULL, 0);
+		else if (!strcmp(argv[i], "--loops") && (i + 1 < argc))
+			loops = strtoul(argv[++i], NULL, 0);
+		else if (!strcmp(argv[i], "--loop-cost-us") && (i + 1 < argc))
+			loopCostUs = strtoul(argv[++i], NULL, 0);
+		else if (!strcmp(argv[i], "--hop-us") && (i + 1 < argc))
+			config.tokenHopUs = strtoul(argv[++i], NULL, 0);
+		else if (!strcmp(argv[i], "--hop-jitter-us") && (i + 1 < argc))
+			config.tokenHopJitterUs = strtoul(argv[++i], NULL, 0);
+		else if (!strcmp(argv[i], "--nack-rate") && (i + 1 < argc))
+			config.nackRate = strtod(argv[++i], NULL);
+		else if (!strcmp(argv[i], "--storm-gap-us") && (i + 1 < argc))
+			stormGapUs = strtoul(argv[++i], NULL, 0);
+		else if (!strcmp(argv[i], "--storm-hold-us") && (i + 1 < argc))
+			stormHoldUs = strtoul(argv[++i], NULL, 0);
+		else if (!strcmp(argv[i], "--storm-ms") && (i + 1 < argc))
+			stormMs = strtoul(argv[++i], NULL, 0);
+		else if (!strcmp(argv[i], "--echo"))
+			echo = true;
+		else
+		{
+			fprintf(stderr, "usage: %s [--modules N] [--loops N] [--loop-cost-us N] [--hop-us N] [--hop-jitter-us N]\n"
+				"       [--nack-rate P] [--storm-gap-us N] [--storm-hold-us N] [--storm-ms N] [--echo]\n", argv[0]);
+
+			return 1;
+		}
+	}
+
+	halReset();
+	halSerialSetEcho(echo);
+
+	ModuleChain chain(modules, config);
+
+	chain.attach();
+
+	double start = wallSeconds();
+
+	setup();
+
+	uint32_t bootUs = halMicros();
+	double bootWall = wallSeconds() - start;
+
+	if (stormGapUs)
+	{
+		chain.storm(bootUs, stormMs * 1000, stormGapUs, stormHoldUs);
+
+		stormEndUs = bootUs + stormMs * 1000 + stormHoldUs;
+	}
+
+	start = wallSeconds();
+
+	for (unsigned long i = 0; i < loops; ++i)
+	{
+		loop();
+
+		halAdvanceMicros(loopCostUs);
+	}
+
+	// Let the storm play out
+	while ((stormGapUs) && ((int32_t)(halMicros() - stormEndUs) < 0))
+	{
+		loop();
+
+		halAdvanceMicros(loopCostUs);
+
+		loops++;
+	}
+
+	double loopWall = wallSeconds() - start;
+	uint32_t loopUs = halMicros() - bootUs;
+
+	printf("modules:            %lu\n", modules);
+	printf("boot (virtual):     %.3f ms\n", bootUs / 1000.0);
+	printf("boot (host):        %.3f ms\n", bootWall * 1000.0);
+	printf("loops:              %lu\n", loops);
+	printf("loop (virtual avg): %.2f us\n", loops ? (double)loopUs / loops : 0.0);
+	printf("loop (host avg):    %.3f us\n", loops ? loopWall * 1e6 / loops : 0.0);
+	printf("loops/s (host):     %.0f\n", loopWall > 0 ? loops / loopWall : 0.0);
+	printf("max irq-off:        %u us\n", halMaxInterruptsOffMicros());
+	printf("i2c acks/nacks:     %u/%u (%u injected)\n", chain.stats().acks, chain.stats().nacks, chain.stats().injectedNacks);
+	printf("hid reports:        %u\n", halHidReports());
+	printf("eeprom writes:      %u\n", halEepromTotalWrites());
+
+	if (stormGapUs)
+	{
+		struct event_stats_s stats;
+		uint32_t sent = chain.stats().eventsSent;
+		uint32_t dropped = halI2cSlaveWritesDropped();
+
+		if (!queryEventStats(&stats))
+		{
+			fprintf(stderr, "no event stats from firmware\n");
+
+			return 1;
+		}
+
+		uint32_t missed = dropped + stats.overflows + stats.invalid;
+
+		printf("events sent:        %u\n", sent);
+		printf("events missed:      %u (%.3f%%): %u not listening, %u queue full, %u bad addr\n", missed,
+			sent ? 100.0 * missed / sent : 0.0, dropped, stats.overflows, stats.invalid);
+		printf("max queue depth:    %u\n", stats.maxDepth);
+		printf("max event latency:  %u us\n", stats.maxLatencyUs);
+	}
+
+	return 0;
+}
@@ -0,0 +1,268 @@
+// Software model of a chain of paws button modules on the host HAL.
+#include <string.h>
+
+#include "ModuleChain.h"
+
+module_chain_config_s ModuleChain::defaultConfig()
+{
+	module_chain_config_s config;
+
+	config.tokenSendPin = 5;
+	config.tokenRecvPin = 4;
+	config.bcastAddr = 0;
+	config.assignDelayUs = 200;
+	config.tokenHopUs = 50;
+	config.tokenHopJitterUs = 0;
+	config.nackRate = 0.0;
+	config.keepAddressOnReset = true;
+	config.seed = 1;
+
+	return config;
+}
+
+ModuleChain::ModuleChain(size_t count, const module_chain_config_s& config) :
+	_config(config),
+	_modules(count)
+{
+	memset(&_stats, 0, sizeof(_stats));
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		_modules[i].addr = 0;
+		_modules[i].pendingAddr = 0;
+		_modules[i].readyAt = 0;
+		_modules[i].tokenIn = false;
+		_modules[i].tokenOut = false;
+	}
+
+	srand(config.seed);
+}
+
+void ModuleChain::attach()
+{
+	halSetI2cBus(this);
+	halSetPinListener(this);
+	halSetPinInput(_config.tokenRecvPin, LOW);
+}
+
+void ModuleChain::preassign(uint8_t baseAddr)
+{
+	for (size_t i = 0; i < _modules.size(); ++i)
+	{
+		_modules[i].addr = baseAddr + i;
+		_modules[i].pendingAddr = 0;
+	}
+}
+
+ModuleChain::module_s* ModuleChain::find(uint8_t addr)
+{
+	uint32_t now = halMicros();
+
+	for (size_t i = 0; i < _modules.size(); ++i)
+	{
+		module_s& m = _modules[i];
+
+		// A pending assignment takes effect once the module re-initialized its TWI
+		if ((m.pendingAddr != 0) && ((int32_t)(now - m.readyAt) >= 0))
+		{
+			m.addr = m.pendingAddr;
+			m.pendingAddr = 0;
+		}
+
+		if ((m.addr == addr) && (m.pendingAddr == 0))
+		{
+			return &m;
+		}
+	}
+
+	return NULL;
+}
+
+bool ModuleChain::masterWrite(uint8_t addr, const uint8_t* data, size_t len)
+{
+	if (addr == _config.bcastAddr)
+	{
+		_stats.broadcasts++;
+
+		if (len < 1)
+		{
+			return !_modules.empty();
+		}
+
+		// Only the module currently holding the token takes the address
+		for (size_t i = 0; i < _modules.size(); ++i)
+		{
+			module_s& m = _modules[i];
+
+			// A repeated broadcast of the same address does not restart it
+			if (m.tokenIn && !m.tokenOut && (m.pendingAddr != data[0]) && ((m.addr != data[0]) || (m.pendingAddr != 0)))
+			{
+				m.pendingAddr = data[0];
+				m.readyAt = halMicros() + _config.assignDelayUs;
+			}
+		}
+
+		return !_modules.empty();
+	}
+
+	_stats.probes++;
+
+	return find(addr) != NULL;
+}
+
+size_t ModuleChain::masterRead(uint8_t addr, uint8_t* data, size_t len)
+{
+	module_s* m = find(addr);
+
+	if ((m == NULL) || (len < 1))
+	{
+		_stats.nacks++;
+
+		return 0;
+	}
+
+	if ((_config.nackRate > 0) && ((double)rand() / RAND_MAX < _config.nackRate))
+	{
+		_stats.injectedNacks++;
+
+		return 0;
+	}
+
+	data[0] = m->addr;
+
+	_stats.acks++;
+
+	// Acknowledged while holding the token: pass it on
+	if (m->tokenIn && !m->tokenOut)
+	{
+		token_event_s* ev = new token_event_s;
+
+		ev->chain = this;
+		ev->idx = m - &_modules[0];
+
+		uint32_t hopUs = _config.tokenHopUs;
+
+		if (_config.tokenHopJitterUs > 0)
+		{
+			hopUs += rand() % (_config.tokenHopJitterUs + 1);
+		}
+
+		halScheduleEvent(halMicros() + hopUs, raiseTokenOut, ev);
+	}
+
+	return 1;
+}
+
+void ModuleChain::raiseTokenOut(void* ctx)
+{
+	token_event_s* ev = (token_event_s*)ctx;
+	ModuleChain* chain = ev->chain;
+	size_t idx = ev->idx;
+
+	delete ev;
+
+	// Token line was reset meanwhile
+	if (!chain->_modules[idx].tokenIn)
+	{
+		return;
+	}
+
+	chain->_modules[idx].tokenOut = true;
+
+	if (idx + 1 < chain->_modules.size())
+	{
+		chain->setTokenIn(idx + 1, true);
+	}
+	else
+	{
+		halSetPinInput(chain->_config.tokenRecvPin, HIGH);
+	}
+}
+
+void ModuleChain::setTokenIn(size_t idx, bool val)
+{
+	_modules[idx].tokenIn = val;
+
+	if (val)
+	{
+		return;
+	}
+
+	// Token dropped: the rest of the chain follows
+	for (size_t i = idx; i < _modules.size(); ++i)
+	{
+		_modules[i].tokenIn = false;
+		_modules[i].tokenOut = false;
+		_modules[i].pendingAddr = 0;
+
+		if (!_config.keepAddressOnReset)
+		{
+			_modules[i].addr = 0;
+		}
+	}
+
+	halSetPinInput(_config.tokenRecvPin, LOW);
+}
+
+void ModuleChain::onPinWrite(uint8_t pin, uint8_t val)
+{
+	if (pin != _config.tokenSendPin)
+	{
+		return;
+	}
+
+	if (_modules.empty())
+	{
+		// Token send is looped straight back
+		halSetPinInput(_config.tokenRecvPin, val);
+
+		return;
+	}
+
+	setTokenIn(0, val == HIGH);
+}
+
+void ModuleChain::sendState(size_t idx, uint32_t atUs, bool pressed)
+{
+	uint8_t data = (_modules[idx].addr & 0x7f) | (pressed ? 0x80 : 0x00);
+
+	_stats.eventsSent++;
+
+	halI2cSlaveWrite(atUs, _config.bcastAddr, &data, 1);
+}
+
+void ModuleChain::press(size_t idx, uint32_t atUs)
+{
+	sendState(idx, atUs, true);
+}
+
+void ModuleChain::release(size_t idx, uint32_t atUs)
+{
+	sendState(idx, atUs, false);
+}
+
+size_t ModuleChain::storm(uint32_t startUs, uint32_t durationUs, uint32_t gapUs, uint32_t holdUs)
+{
+	uint32_t atUs = startUs;
+	size_t presses = 0;
+
+	if (_modules.empty())
+	{
+		return 0;
+	}
+
+	// Uniform gaps in [0, 2 * gapUs] average to gapUs
+	while ((uint32_t)(atUs - startUs) < durationUs)
+	{
+		size_t idx = rand() % _modules.size();
+
+		press(idx, atUs);
+		release(idx, atUs + holdUs);
+
+		presses++;
+
+		atUs += (gapUs > 0) ? rand() % (2 * gapUs + 1) : 1;
+	}
+
+	return presses;
+}
@@ -0,0 +1,113 @@
+// Software model of a chain of paws button modules on the host HAL.
+//
+// Each module sits between a token-in and a token-out line. The master drives
+// the first token-in and reads the last token-out back. A module holding the
+// token takes the address the master broadcasts, answers a read on it with
+// the same address, then raises its token-out for the next module. Once
+// addressed, a module reports presses and releases as single byte writes
+// (address | 0x80 for pressed) to the broadcast address.
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include <Arduino.h>
+
+struct module_chain_config_s
+{
+	// Firmware pins the chain is wired to
+	uint8_t tokenSendPin;
+	uint8_t tokenRecvPin;
+
+	// Broadcast address the master assigns on and listens to
+	uint8_t bcastAddr;
+
+	// Time a module needs after the broadcast before it answers on its new address
+	uint32_t assignDelayUs;
+
+	// Time between a module's ACK and its token-out rising, plus up to
+	// tokenHopJitterUs more picked at random per hop
+	uint32_t tokenHopUs;
+	uint32_t tokenHopJitterUs;
+
+	// Probability that an assignment read is NACKed anyway
+	double nackRate;
+
+	// Modules keep their address when the master resets the token line
+	bool keepAddressOnReset;
+
+	unsigned seed;
+};
+
+struct module_chain_stats_s
+{
+	uint32_t broadcasts;
+	uint32_t acks;
+	uint32_t nacks;
+	uint32_t injectedNacks;
+	uint32_t probes;
+	uint32_t eventsSent;
+};
+
+class ModuleChain : public HalI2cBus, public HalPinListener
+{
+public:
+	static module_chain_config_s defaultConfig();
+
+	ModuleChain(size_t count, const module_chain_config_s& config = defaultConfig());
+
+	// Connect to the HAL as I2C bus and token line listener
+	void attach();
+
+	size_t count() const { return _modules.size(); }
+
+	// Address a module answers on, 0 if unassigned
+	uint8_t address(size_t idx) const { return _modules[idx].addr; }
+
+	// Give every module its address up front, as after a previous enumeration
+	void preassign(uint8_t baseAddr);
+
+	// Schedule a press or release of module idx at virtual time atUs
+	void press(size_t idx, uint32_t atUs);
+	void release(size_t idx, uint32_t atUs);
+
+	// Random presses of random modules from startUs on, gapUs apart on
+	// average, each held for holdUs. Returns the number of presses scheduled.
+	size_t storm(uint32_t startUs, uint32_t durationUs, uint32_t gapUs, uint32_t holdUs);
+
+	const module_chain_stats_s& stats() const { return _stats; }
+
+	// HalI2cBus
+	virtual bool masterWrite(uint8_t addr, const uint8_t* data, size_t len);
+	virtual size_t masterRead(uint8_t addr, uint8_t* data, size_t len);
+
+	// HalPinListener
+	virtual void onPinWrite(uint8_t pin, uint8_t val);
+
+private:
+	struct module_s
+	{
+		uint8_t addr;
+		uint8_t pendingAddr;
+		uint32_t readyAt;
+		bool tokenIn;
+		bool tokenOut;
+	};
+
+	struct token_event_s
+	{
+		ModuleChain* chain;
+		size_t idx;
+	};
+
+	module_chain_config_s _config;
+	std::vector<module_s> _modules;
+	module_chain_stats_s _stats;
+
+	void setTokenIn(size_t idx, bool val);
+	void sendState(size_t idx, uint32_t atUs, bool pressed);
+	module_s* find(uint8_t addr);
+
+	static void raiseTokenOut(void* ctx);
+};
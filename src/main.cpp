@@ -4,26 +4,64 @@
 #include <EEPROM.h>
 #include <Wire.h>
 #include <Keyboard.h>
+#include <KeyboardLayout.h>
 #include <NeoPixelBus.h>
+#include <new>
 
-#define MAX_KEY_COUNT 128
+// Layout the host uses, for Keyboard.begin() and the report accumulator
+#define KEYBOARD_LAYOUT KeyboardLayout_en_US
 #define MAX_BUFFER_DATA (16)
 
-#define EEPROM_ADDR_IS_CONFIG 0x0
-#define EEPROM_ADDR_CONFIG_SIZE 0x1
-#define EEPROM_ADDR_CONFIG_START 0x3
+// Read button bindings and colors from the EEPROM config when needed instead
+// of loading them to RAM. Frees the RAM, but a read has to wait for an EEPROM
+// byte write in progress to finish (config uploads).
+// #define CONFIG_XIP
+
+// The config is kept in two slots, A and B, each committed by writing its
+// header last. Uploads go to the slot not in use, so the previous config
+// survives a power loss mid write and both halves share the wear.
+// | magic (2) | seq (2) | size (2) | crc16 of seq, size and config (2) | config |
+#define EEPROM_SLOT_MAGIC 0x4643
+#define EEPROM_SLOTS 2
+#define EEPROM_SLOT_HEADER_SIZE 8
+#define EEPROM_SLOT_SIZE (EEPROM_ADDR_WEAR / EEPROM_SLOTS)
+#define EEPROM_ADDR_SLOT(slot) ((slot) * EEPROM_SLOT_SIZE)
+#define EEPROM_ADDR_SLOT_MAGIC(slot) (EEPROM_ADDR_SLOT(slot) + 0)
+#define EEPROM_ADDR_SLOT_SEQ(slot) (EEPROM_ADDR_SLOT(slot) + 2)
+#define EEPROM_ADDR_SLOT_SIZE(slot) (EEPROM_ADDR_SLOT(slot) + 4)
+#define EEPROM_ADDR_SLOT_CRC(slot) (EEPROM_ADDR_SLOT(slot) + 6)
+#define EEPROM_ADDR_SLOT_CONFIG(slot) (EEPROM_ADDR_SLOT(slot) + EEPROM_SLOT_HEADER_SIZE)
+
+// Module chain of the last enumeration, kept at the very end of the EEPROM so
+// a growing config never reaches it
+#define EEPROM_TOPOLOGY_MAGIC 0x5054
+#define EEPROM_TOPOLOGY_SIZE 5
+#define EEPROM_ADDR_TOPOLOGY (E2END + 1 - EEPROM_TOPOLOGY_SIZE)
+#define EEPROM_ADDR_TOPOLOGY_MAGIC (EEPROM_ADDR_TOPOLOGY + 0)
+#define EEPROM_ADDR_TOPOLOGY_COUNT (EEPROM_ADDR_TOPOLOGY + 2)
+#define EEPROM_ADDR_TOPOLOGY_BASE (EEPROM_ADDR_TOPOLOGY + 3)
+#define EEPROM_ADDR_TOPOLOGY_CHECKSUM (EEPROM_ADDR_TOPOLOGY + 4)
+
+// Byte writes per EEPROM region, persisted right below the topology record
+#define EEPROM_WEAR_MAGIC 0x5257
+#define EEPROM_WEAR_REGION_SIZE 64
+#define EEPROM_WEAR_REGIONS ((E2END + 1) / EEPROM_WEAR_REGION_SIZE)
+#define EEPROM_ADDR_WEAR (EEPROM_ADDR_TOPOLOGY - sizeof(struct eeprom_wear_s))
+
+// Config may use a slot, less its header
+#define EEPROM_CONFIG_MAX_SIZE (EEPROM_SLOT_SIZE - EEPROM_SLOT_HEADER_SIZE)
+
+// Upper bound of EEPROM bytes compared per loop() by the background writer
+#define EEPROM_WRITER_MAX_READS 64
 
 #define SERIAL_RECV_CONFIG_MAGIC 0x4141
 #define SERIAL_SEND_CONNECTED_MODULES 0x4242
 #define SERIAL_SEND_PRESSES 0x4343
 #define SERIAL_SEND_PRESSES_RELEASE 0x4444
-
-struct serial_config_s
-{
-	uint16_t magic;
-	uint16_t size;
-	uint8_t data[0];
-};
+#define SERIAL_SEND_EVENT_STATS 0x4545
+#define SERIAL_SEND_ENUM_TIME 0x4646
+#define SERIAL_SEND_EEPROM_WEAR 0x4747
+#define SERIAL_SEND_LOOP_STATS 0x4848
 
 static bool sendBtnPressesOverSerial = false;
 
@@ -31,10 +69,6 @@ static bool sendBtnPressesOverSerial = false;
 #define TOKEN_RECV_PIN 4
 #define TOKEN_SEND_PIN 5
 
-#ifndef O_NONBLOCK
-#define O_NONBLOCK 00004000
-#endif
-
 unsigned int parse_state = 0;
 
 #define CONFIG_MAGIC_IDX (0)
@@ -77,17 +111,17 @@ enum btn_press_type_e
 
 #define BASE_ASSIGN_ADDR 2
 
-static enum btn_state_e* btnStates = NULL;
-static uint8_t assignAddr = BASE_ASSIGN_ADDR;
+// Modules take 7-bit I2C addresses from BASE_ASSIGN_ADDR up to the reserved 0x78
+#define MAX_MODULES (0x78 - BASE_ASSIGN_ADDR)
 
-struct key_obj_s
-{
-	uint8_t keyValue;
-	enum btn_press_type_e press_type;
-	unsigned long cooldown;
-	unsigned long tick;
-	struct key_obj_s* next;
-};
+// Continuous keys repeat after KEY_REPEAT_DELAY_MS, then every KEY_REPEAT_RATE_MS
+#define KEY_REPEAT_DELAY_MS 300
+#define KEY_REPEAT_RATE_MS 30
+
+// Buttons repeating at once - More than a report has keys for is of no use
+#define KEY_REPEAT_SLOTS 6
+
+static uint8_t assignAddr = BASE_ASSIGN_ADDR;
 
 struct led_obj_s
 {
@@ -100,41 +134,57 @@ enum animation_type
 {
 	ANIMATION_GRADIENT = 0,
 	ANIMATION_PULSE = 1,
-	ANIMATION_STILL = 2
+	ANIMATION_STILL = 2,
+	ANIMATION_NONE = 0xff
 };
 
-struct animation_obj_s
-{
-	enum animation_type type;
+// Config of a button as loaded to RAM, one fixed size record per button. Its
+// keys are btnKeys[keyHead, keyHead + keyCount). Not used with CONFIG_XIP.
+#define BTN_CONFIG_CLICK_COLOR 0x80
+#define BTN_CONFIG_ANIMATION 0x40
+#define BTN_CONFIG_ANIMATION_TYPE 0x0f
 
-	struct led_obj_s color;
+struct key_cfg_s
+{
+	uint8_t keyValue;
+	uint8_t pressType;
 };
 
-struct config_obj_s
+struct btn_cfg_s
 {
-	uint8_t type;
-	uint8_t btnIdx;
+	uint8_t keyHead;
+	uint8_t keyCount;
 
-	union
-	{
-		struct key_obj_s key;
+	// BTN_CONFIG_* flags | animation type
+	uint8_t flags;
+
+	// Indexes into btnColors, valid with their BTN_CONFIG_* flag
+	uint8_t clickColor;
+	uint8_t animationColor;
+};
 
-		struct led_obj_s clickColor;
+// Runtime state of a button, kept apart from its config
+struct btn_runtime_s
+{
+	uint8_t state;
 
-		struct animation_obj_s animation;
+	// Offset on the color wheel, spreads the gradient over the chain
+	uint8_t phase;
 
-		uint8_t tmp[CONFIG_OBJ_SIZE];
-	} data;
+	// Shared animation, ANIMATION_CLASS_NONE if rendered on its own
+	uint8_t animClass;
 };
 
-struct config_s
+// A held button with continuous keys
+struct key_repeat_s
 {
-	uint16_t configMagic;
-	uint16_t configObjNum;
-	struct config_obj_s objects[0];
+	uint8_t btnIdx;
+
+	// Low 16 bits of millis() at the next repeat
+	uint16_t at;
 };
 
-struct config_s* config = NULL;
+static bool configured = false;
 
 // ***** CONFIG PROTOCOL DEFINITION *****
 // Protocol is little-endian ints
@@ -160,456 +210,1856 @@ static unsigned tokenRecvCnt;
 static unsigned tokenSentCnt;
 
 static size_t btnNum = 0;
-static uint16_t animationCycle = 0;
-static struct key_obj_s** keyMap = NULL;
-static struct led_obj_s** ledsMap = NULL;
-static struct animation_obj_s** animationMap = NULL;
 
-NeoPixelBus<NeoGrbFeature, Neo800KbpsMethod> ledStrip(MAX_KEY_COUNT, LEDS_PIN);
+// Time from kicking the chain to the last address assigned
+static unsigned long enumTimeUs = 0;
+static uint16_t enumPolls = 0;
 
-static void eepromWriteByte(unsigned addr, uint8_t data)
-{
-	EEPROM.write(addr, data);
-}
+// Animation phases, 8.8 fixed point - The integer part indexes the tables
+static uint16_t animationPhase = 0;
+static uint16_t animationPulsePhase = 0;
 
-static uint8_t eepromReadByte(unsigned addr)
-{
-	return EEPROM.read(addr);
-}
+// Pulse brightness of the current frame
+static uint8_t animationPulseLevel = 0;
 
-static void eepromWriteHWord(unsigned addr, uint16_t data)
-{
-	EEPROM.write(addr + 0, (data & 0x00ff) >> 0);
-	EEPROM.write(addr + 1, (data & 0xff00) >> 8);
-}
+// LED frames are rendered at a fixed rate, independent of the scan loop
+#ifndef LED_TARGET_FPS
+#define LED_TARGET_FPS 50
+#endif
 
-static uint16_t eepromReadHWord(unsigned addr)
-{
-	uint16_t data = 0;
+#define LED_FRAME_MS (1000 / LED_TARGET_FPS)
 
-	data |= EEPROM.read(addr + 0) << 0;
-	data |= EEPROM.read(addr + 1) << 8;
+// Phase advance per ms: a color wheel step every 16 ms, a pulse every 8.2 s
+#define ANIMATION_PHASE_PER_MS 16
+#define ANIMATION_PULSE_PHASE_PER_MS 8
+#ifndef CONFIG_XIP
+static struct btn_cfg_s* btnConfig = NULL;
+static struct key_cfg_s* btnKeys = NULL;
 
-	return data;
-}
+// Distinct colors of the config - Most repeat a few over the whole chain
+static struct led_obj_s* btnColors = NULL;
+static uint8_t btnColorNum = 0;
+#endif
+static struct btn_runtime_s* btnRuntime = NULL;
 
-static void eepromDumpConfig(uint8_t* config, uint16_t size)
-{
-	unsigned i;
+// Repeat timers live here rather than per button, few are ever held at once
+static struct key_repeat_s keyRepeats[KEY_REPEAT_SLOTS];
+static uint8_t keyRepeatNum = 0;
 
-	eepromWriteByte(EEPROM_ADDR_IS_CONFIG, 1);
+// Sent two pixels per interrupt-masked window, so TWI and USB interrupts wait
+// tens of microseconds behind Show() rather than the whole frame
+typedef NeoPixelBus<NeoGrbFeature, NeoChunked800KbpsMethod> led_strip_t;
 
-	// Write the config size
-	eepromWriteHWord(EEPROM_ADDR_CONFIG_SIZE, size);
+// Sized to the enumerated modules, so Show() only clocks out real pixels
+static led_strip_t* ledStrip = NULL;
 
-	// Dump the config
-	for (i = 0; i < size; ++i)
-	{
-		eepromWriteByte(EEPROM_ADDR_CONFIG_START + i, config[i]);
-	}
-}
+// Called between the windows of a frame, with the key handling below
+static void ledShowGap(void* context);
 
-static bool isConfigured()
+static int ledStripResize(uint16_t count)
 {
-	static bool isConf = false;
+	led_strip_t* nustrip;
 
-	if (!isConf)
-		isConf = (eepromReadByte(EEPROM_ADDR_IS_CONFIG) == 1) ? true : false;
-
-	return isConf;
-}
+	if ((ledStrip) && (ledStrip->PixelCount() == count))
+	{
+		return 0;
+	}
 
-static uint16_t eepromLoadConfig(uint8_t** config)
-{
-	uint16_t size = 0;
-	unsigned i;
+	nustrip = new (std::nothrow) led_strip_t(count, LEDS_PIN);
 
-	if (!isConfigured())
+	if ((!nustrip) || ((!nustrip->Pixels()) && (count)))
 	{
-		Serial.println("Could not load config. Not initialized.");
+		delete nustrip;
 
-		goto error;
+		return -1;
 	}
 
-	// Read the size
-	size = eepromReadHWord(EEPROM_ADDR_CONFIG_SIZE);
+	nustrip->Begin();
+	nustrip->Method().SetGapCallback(ledShowGap, NULL);
 
-	// Allocate data
-	*config = (uint8_t*)malloc(size);
-
-	// Read the data
-	for (i = 0; i < size; ++i)
+	if (ledStrip)
 	{
-		(*config)[i] = eepromReadByte(EEPROM_ADDR_CONFIG_START + i);
+		// Keep what was already drawn
+		memcpy(nustrip->Pixels(), ledStrip->Pixels(), min(nustrip->PixelsSize(), ledStrip->PixelsSize()));
+		nustrip->Dirty();
+
+		delete ledStrip;
+
+		// Old strip released the pin on destruction
+		pinMode(LEDS_PIN, OUTPUT);
 	}
 
-error:
-	return size;
+	ledStrip = nustrip;
+
+	return 0;
 }
 
-#define TIMEOUT_MS 1000
+// ***** LOOP STATS *****
+// Time spent in each loop() stage, loop() period and TWI ISR entries since
+// the last SERIAL_SEND_LOOP_STATS query. Release builds leave it all out.
+// #define PAWS_RELEASE
 
-static int serialRecv(uint8_t* buf, size_t size, int flags = 0)
+#ifndef PAWS_RELEASE
+enum loop_stage_e
 {
-	int err = -1;
-	size_t read = 0;
-	unsigned long last_read = millis();
+	LOOP_STAGE_LED = 0,
+	LOOP_STAGE_SHOW,
+	LOOP_STAGE_SERIAL,
+	LOOP_STAGE_EEPROM,
+	LOOP_STAGE_KEYS,
+	LOOP_STAGE_HID,
+	LOOP_STAGES
+};
 
-	if ((flags & O_NONBLOCK) && (Serial.readBytes(buf, size) != size))
-	{
-		goto error;
-	}
+// Loop periods by power of 2: < 64us, < 128us, ... , >= 4096us
+#define LOOP_PERIOD_BINS 8
+#define LOOP_PERIOD_BIN0_SHIFT 6
 
-	while (read != size)
-	{
-		while ((!Serial.available()) && (millis() - last_read < TIMEOUT_MS))
-			;
+struct loop_stats_s
+{
+	uint32_t loops;
+	uint32_t periodTotalUs;
+	uint16_t periodMaxUs;
+	uint32_t periodBins[LOOP_PERIOD_BINS];
+	uint32_t stageTotalUs[LOOP_STAGES];
+	uint16_t stageMaxUs[LOOP_STAGES];
+	uint16_t shows;
+};
+
+static struct loop_stats_s loopStats;
+static volatile uint16_t loopStatsIsrEntries = 0;
 
-		// Did I quit the loop with nothing to read?
-		if (!Serial.available())
+// Start of the current loop() pass and of its current stage
+static unsigned long loopStatsLoopAt = 0;
+static unsigned long loopStatsStageAt = 0;
+
+static void loopStatsBegin()
+{
+	unsigned long now = micros();
+	unsigned long period = now - loopStatsLoopAt;
+	unsigned long p;
+	uint8_t bin = 0;
+
+	// Nothing to measure before the first pass
+	if (loopStatsLoopAt != 0)
+	{
+		for (p = period >> LOOP_PERIOD_BIN0_SHIFT; (p) && (bin < LOOP_PERIOD_BINS - 1); p >>= 1)
 		{
-			goto error;
+			bin++;
 		}
 
-		read += Serial.readBytes(buf + read, size - read);
+		loopStats.loops++;
+		loopStats.periodTotalUs += period;
+		loopStats.periodMaxUs = max(loopStats.periodMaxUs, (uint16_t)min(period, 0xffffUL));
 
-		// Mark the last read
-		last_read = millis();
+		loopStats.periodBins[bin]++;
 	}
 
-	err = 0;
-error:
-	return err;
+	loopStatsLoopAt = now;
+	loopStatsStageAt = now;
 }
 
-static int parseConfig(uint8_t* buf, size_t size)
+// Charge the time since the previous stage ended to stage
+static void loopStatsStage(uint8_t stage)
 {
-	int err = -1;
-	uint16_t magic;
-	uint16_t objnum;
-	size_t i;
-	unsigned configObjId;
-	struct config_s* nuconfig;
+	unsigned long now = micros();
+	unsigned long dt = now - loopStatsStageAt;
 
-	// Check magic
-	magic = (buf[CONFIG_MAGIC_IDX + 0] << 0) | (buf[CONFIG_MAGIC_IDX + 1] << 8);
-
-	if (magic != CONFIG_BEGIN)
-	{
-		Serial.println("Error parsing config: Invalid magic.");
+	loopStats.stageTotalUs[stage] += dt;
+	loopStats.stageMaxUs[stage] = max(loopStats.stageMaxUs[stage], (uint16_t)min(dt, 0xffffUL));
 
-		goto error;
-	}
-
-	// Get number of objects
-	objnum = (buf[CONFIG_OBJNUM_IDX + 0] << 0) | (buf[CONFIG_OBJNUM_IDX + 1] << 8);
+	loopStatsStageAt = now;
+}
 
-	// Check that recv size correlates to number of objects
-	if (size != (CONFIG_MAGIC_SIZE + CONFIG_OBJNUM_SIZE + CONFIG_OBJ_SIZE * objnum))
-	{
-		Serial.println("Error parsing config: Invalid config sizes. Expected: " +
-			String(CONFIG_MAGIC_SIZE + CONFIG_OBJNUM_SIZE + CONFIG_OBJ_SIZE * objnum) + " Got: " + String(size));
+#define LOOP_STATS_BEGIN() loopStatsBegin()
+#define LOOP_STATS_STAGE(stage) loopStatsStage(stage)
+#define LOOP_STATS_SHOW() loopStats.shows++
+#define LOOP_STATS_ISR() loopStatsIsrEntries++
+#else
+#define LOOP_STATS_BEGIN()
+#define LOOP_STATS_STAGE(stage)
+#define LOOP_STATS_SHOW()
+#define LOOP_STATS_ISR()
+#endif
 
-		goto error;
-	}
+// ***** BUTTON EVENT QUEUE *****
+// Single producer (dataHandler() in the TWI ISR), single consumer (loop()).
+// Each side only writes its own index, and a byte index is read and written
+// atomically on AVR, so no locking is needed. Every edge is kept, even when
+// several arrive between two loop() passes.
+#define BTN_EVENT_QUEUE_SIZE (32) // Must be a power of 2
 
-	// Allocate config
-	nuconfig = (struct config_s*)realloc(config, sizeof(struct config_s) + sizeof(struct config_obj_s) * objnum);
+struct btn_event_s
+{
+	uint8_t addr;
+	uint8_t state;
+	unsigned long timestamp;
+};
 
-	// Populate fields
-	nuconfig->configMagic = magic;
-	nuconfig->configObjNum = objnum;
+static volatile struct btn_event_s btnEvents[BTN_EVENT_QUEUE_SIZE];
+static volatile uint8_t btnEventsHead = 0;
+static volatile uint8_t btnEventsTail = 0;
 
-	// Reset previous keys/led/animation configs
-	for (i = 0; i < btnNum; ++i)
-	{
-		keyMap[i] = NULL;
-		ledsMap[i] = NULL;
-		animationMap[i] = NULL;
+// Diagnostics, see SERIAL_SEND_EVENT_STATS
+static volatile uint16_t btnEventsOverflows = 0;
+static volatile uint16_t btnEventsInvalid = 0;
+static uint8_t btnEventsMaxDepth = 0;
+static unsigned long btnEventsMaxLatency = 0;
 
-	}
+static void dataHandler(int size)
+{
+	LOOP_STATS_ISR();
 
-	// Populate objects
-	for (i = 0, configObjId = 0; i < nuconfig->configObjNum; ++i)
+	while (Wire.available() > 0)
 	{
-		uint8_t configType = buf[CONFIG_OBJARR_IDX + i * CONFIG_OBJ_SIZE + CONFIG_OBJ_TYPE_OFFSET];
-		uint8_t btnIdx = buf[CONFIG_OBJARR_IDX + i * CONFIG_OBJ_SIZE + CONFIG_OBJ_BTN_IDX_OFFSET];
-
-		if (btnIdx >= btnNum)
+		// Get the addr
+		uint8_t data = Wire.read();
+		uint8_t addrRecvd = data & 0b01111111;
+		uint8_t head = btnEventsHead;
+		uint8_t next = (head + 1) & (BTN_EVENT_QUEUE_SIZE - 1);
+
+		// Not an address this master handed out
+		if ((addrRecvd < BASE_ASSIGN_ADDR) || (addrRecvd >= assignAddr))
 		{
-			// Ignore this config - No such button idx.
+			btnEventsInvalid++;
+
 			continue;
 		}
 
-		switch (configType)
+		if (next == btnEventsTail)
 		{
-			case CONFIG_KEY:
-			{
-				uint8_t keyValue = buf[CONFIG_OBJARR_IDX + i * CONFIG_OBJ_SIZE + CONFIG_OBJ_DATA_OFFSET + CONFIG_OBJ_KEYVAL_IDX];
-				uint8_t press_type = buf[CONFIG_OBJARR_IDX + i * CONFIG_OBJ_SIZE + CONFIG_OBJ_DATA_OFFSET + CONFIG_OBJ_KEYVAL_PRESS_TYPE];
+			btnEventsOverflows++;
 
-				nuconfig->objects[configObjId].data.key.keyValue = keyValue;
-				nuconfig->objects[configObjId].data.key.press_type = (press_type == 0) ? BTN_PRESS_TYPE_ONCE : BTN_PRESS_TYPE_CONT;
-				nuconfig->objects[configObjId].data.key.cooldown = 0;
-				nuconfig->objects[configObjId].data.key.tick = 0;
-				nuconfig->objects[configObjId].data.key.next = NULL;
+			continue;
+		}
 
-				// Map keys
-				if (keyMap[btnIdx] == NULL)
-				{
-					// Serial.println("Setting button " + String(btnIdx) + " with object: " + String((unsigned int)&nuconfig->objects[configObjId].data.key, 16));
+		btnEvents[head].addr = addrRecvd;
+		btnEvents[head].state = (data & 0b10000000) == 0 ? BTN_STATE_RELEASED : BTN_STATE_PRESSED;
+		btnEvents[head].timestamp = micros();
 
-					keyMap[btnIdx] = &nuconfig->objects[configObjId].data.key;
-				}
-				else
-				{
-					struct key_obj_s* last = keyMap[btnIdx];
+		// Publish
+		btnEventsHead = next;
+	}
+}
 
-					// Find the last object to append to
-					while (last->next)
-					{
-						last = last->next;
-					}
+static bool btnEventPop(struct btn_event_s* ev)
+{
+	uint8_t tail = btnEventsTail;
+	uint8_t depth = (btnEventsHead - tail) & (BTN_EVENT_QUEUE_SIZE - 1);
 
-					last->next = &nuconfig->objects[configObjId].data.key;
-				}
+	if (depth == 0)
+	{
+		return false;
+	}
 
-				break;
-			}
+	if (depth > btnEventsMaxDepth)
+	{
+		btnEventsMaxDepth = depth;
+	}
 
-			case CONFIG_LED:
-			{
-				nuconfig->objects[configObjId].data.clickColor.ledR =
-					buf[CONFIG_OBJARR_IDX + i * CONFIG_OBJ_SIZE + CONFIG_OBJ_DATA_OFFSET + CONFIG_OBJ_LED_R_IDX];
-				nuconfig->objects[configObjId].data.clickColor.ledG =
-					buf[CONFIG_OBJARR_IDX + i * CONFIG_OBJ_SIZE + CONFIG_OBJ_DATA_OFFSET + CONFIG_OBJ_LED_G_IDX];
-				nuconfig->objects[configObjId].data.clickColor.ledB =
-					buf[CONFIG_OBJARR_IDX + i * CONFIG_OBJ_SIZE + CONFIG_OBJ_DATA_OFFSET + CONFIG_OBJ_LED_B_IDX];
+	ev->addr = btnEvents[tail].addr;
+	ev->state = btnEvents[tail].state;
+	ev->timestamp = btnEvents[tail].timestamp;
 
-				ledsMap[btnIdx] = &nuconfig->objects[configObjId].data.clickColor;
+	// Hand the slot back to the ISR
+	btnEventsTail = (tail + 1) & (BTN_EVENT_QUEUE_SIZE - 1);
 
-				break;
-			}
+	return true;
+}
 
-			case CONFIG_ANIMATION:
-			{
-				nuconfig->objects[configObjId].data.animation.color.ledR =
-					buf[CONFIG_OBJARR_IDX + i * CONFIG_OBJ_SIZE + CONFIG_OBJ_DATA_OFFSET + CONFIG_OBJ_LED_R_IDX];
-				nuconfig->objects[configObjId].data.animation.color.ledG =
-					buf[CONFIG_OBJARR_IDX + i * CONFIG_OBJ_SIZE + CONFIG_OBJ_DATA_OFFSET + CONFIG_OBJ_LED_G_IDX];
-				nuconfig->objects[configObjId].data.animation.color.ledB =
-					buf[CONFIG_OBJARR_IDX + i * CONFIG_OBJ_SIZE + CONFIG_OBJ_DATA_OFFSET + CONFIG_OBJ_LED_B_IDX];
-				nuconfig->objects[configObjId].data.animation.type = (enum animation_type)
-					buf[CONFIG_OBJARR_IDX + i * CONFIG_OBJ_SIZE + CONFIG_OBJ_DATA_OFFSET + CONFIG_OBJ_LED_ANIMATION];
+// ***** EEPROM WRITER *****
+// A byte write keeps the EEPROM busy for ~3.3ms. Writes are queued as a job
+// and carried out from loop(), one byte per pass and only when the EEPROM is
+// idle, skipping bytes that already hold the right value.
+struct eeprom_job_s
+{
+	const uint8_t* data;
+	uint16_t addr;
+	uint16_t size;
+	uint16_t pos;
 
-				animationMap[btnIdx] = &nuconfig->objects[configObjId].data.animation;
+	// Config slot this job fills (-1 if none), becomes current once done
+	int8_t slot;
+	uint16_t seq;
+};
 
-				break;
-			}
+static struct eeprom_job_s eepromJob = { NULL, 0, 0, 0, -1, 0 };
 
-			// Invalid config type
-			default:
-			continue;
-		}
+// Newest valid config slot (-1 if none)
+static int8_t configSlot = -1;
+static uint16_t configSeq = 0;
+
+struct eeprom_wear_s
+{
+	uint16_t magic;
+	uint32_t writes[EEPROM_WEAR_REGIONS];
+};
 
-		nuconfig->objects[configObjId].btnIdx = btnIdx;
-		nuconfig->objects[configObjId].type = configType;
+static struct eeprom_wear_s eepromWear;
+static bool eepromWearDirty = false;
+static bool eepromWearPersisting = false;
 
-		// Serial.println("Configured object #" + String(configObjId));
+static void eepromCountWrite(unsigned addr)
+{
+	eepromWear.writes[addr / EEPROM_WEAR_REGION_SIZE]++;
 
-		// Valid config. Advance...
-		configObjId++;
+	// Writing the table itself must not queue it again
+	if (!eepromWearPersisting)
+	{
+		eepromWearDirty = true;
 	}
+}
 
-	config = nuconfig;
+static void eepromWriteByte(unsigned addr, uint8_t data)
+{
+	eepromCountWrite(addr);
 
-	err = 0;
-error:
-	return err;
+	EEPROM.write(addr, data);
 }
 
-static int handleRecvConfig()
+static void eepromUpdateByte(unsigned addr, uint8_t data)
 {
-	int err = -1;
-	struct serial_config_s* data;
-	uint16_t magic;
-	uint16_t size;
-
-	// Receive size
-	if (serialRecv((uint8_t*)&size, sizeof(uint16_t)) < 0)
+	if (EEPROM.read(addr) != data)
 	{
-		Serial.println("Error recveing config size");
-
-		goto error;
+		eepromWriteByte(addr, data);
 	}
+}
 
-	data = (struct serial_config_s*)malloc(sizeof(struct serial_config_s) + size);
+static uint8_t eepromReadByte(unsigned addr)
+{
+	return EEPROM.read(addr);
+}
 
-	// Populate data
-	if (serialRecv(data->data, size) < 0)
-	{
-		Serial.println("Error receiving config data");
+static uint16_t eepromReadHWord(unsigned addr)
+{
+	uint16_t data = 0;
 
-		goto error;
-	}
+	data |= EEPROM.read(addr + 0) << 0;
+	data |= EEPROM.read(addr + 1) << 8;
 
-	data->magic = magic;
-	data->size = size;
+	return data;
+}
 
-	// Parse the config
-	if (parseConfig(data->data, data->size) < 0)
+static void eepromLoadWear()
+{
+	EEPROM.get(EEPROM_ADDR_WEAR, eepromWear);
+
+	// Never persisted - Start counting from now
+	if (eepromWear.magic != EEPROM_WEAR_MAGIC)
 	{
-		Serial.println("Error parsing config");
+		memset(&eepromWear, 0, sizeof(eepromWear));
 
-		goto error;
+		eepromWear.magic = EEPROM_WEAR_MAGIC;
 	}
+}
 
-	// Dump config to eeprom
-	eepromDumpConfig(data->data, data->size);
-
-	free(data);
-
-	err = 0;
-error:
-	return err;
+static bool eepromWriterBusy()
+{
+	return eepromJob.data != NULL;
 }
 
-static int handleSerialConfig()
+// Is data still being written?
+static bool eepromWriterBusyWith(const uint8_t* data)
 {
-	int err = -1;
-	uint16_t magic;
+	return eepromJob.data == data;
+}
 
-	if (!Serial.available())
+static void eepromWriterRelease()
+{
+	if (eepromJob.data == (uint8_t*)&eepromWear)
 	{
-		goto done;
+		eepromWearPersisting = false;
 	}
 
-	// Read data request
-	if (Serial.read() != 0x42)
+	eepromJob.data = NULL;
+}
+
+// Queue data to be written at addr. data must stay untouched until written.
+static void eepromWriterStart(const uint8_t* data, uint16_t addr, uint16_t size, int8_t slot = -1, uint16_t seq = 0)
+{
+	// A newer write replaces an unfinished one - Bytes it already wrote are skipped
+	if (eepromWriterBusy())
 	{
-		// Serial.println("Error receiving read request magic");
+		// Table was cut short, persist it again later
+		if (eepromJob.data == (uint8_t*)&eepromWear)
+		{
+			eepromWearDirty = true;
+		}
 
-		goto done;
+		eepromWriterRelease();
 	}
 
-	// Write magic number so desktop can identify this as the correct port
-	Serial.write("\x42\x69");
-
-	// Receive magic
-	if (serialRecv((uint8_t*)&magic, sizeof(magic)) < 0)
-	{
-		Serial.println("Error receiving magic number");
+	eepromJob.data = data;
+	eepromJob.addr = addr;
+	eepromJob.size = size;
+	eepromJob.pos = 0;
+	eepromJob.slot = slot;
+	eepromJob.seq = seq;
+}
 
-		goto error;
-	}
+static void eepromWriterRun()
+{
+	unsigned reads = 0;
 
-	// Verify magic
-	switch (magic)
+	if (!eepromWriterBusy())
 	{
-		case SERIAL_RECV_CONFIG_MAGIC:
+		if (!eepromWearDirty)
 		{
-			if (handleRecvConfig() < 0)
-			{
-				Serial.println("Invalid config");
+			return;
+		}
 
-				goto error;
-			}
+		// Counters went up since last persisted
+		eepromWriterStart((uint8_t*)&eepromWear, EEPROM_ADDR_WEAR, sizeof(eepromWear));
 
-			break;
-		}
+		eepromWearDirty = false;
+		eepromWearPersisting = true;
 
-		case SERIAL_SEND_CONNECTED_MODULES:
-		{
-			// Send number of connected modules (max 255)
-			Serial.write((uint8_t*)&btnNum, 1);
+		return;
+	}
 
-			break;
-		}
+	while ((eepromJob.pos < eepromJob.size) && (reads++ < EEPROM_WRITER_MAX_READS))
+	{
+		unsigned addr = eepromJob.addr + eepromJob.pos;
+		uint8_t data = eepromJob.data[eepromJob.pos];
 
-		case SERIAL_SEND_PRESSES:
+		// Don't stall the loop on the previous write
+		if (!eeprom_is_ready())
 		{
-			// Toggle
-			sendBtnPressesOverSerial = true;
-
-			break;
+			return;
 		}
 
-		case SERIAL_SEND_PRESSES_RELEASE:
+		eepromJob.pos++;
+
+		if (EEPROM.read(addr) != data)
 		{
-			// Toggle
-			sendBtnPressesOverSerial = false;
+			// Returns right away, programming goes on in the background
+			eepromWriteByte(addr, data);
 
-			break;
+			return;
 		}
+	}
 
-		default:
-		{
-			Serial.println("Invalid serial magic number");
+	if (eepromJob.pos < eepromJob.size)
+	{
+		return;
+	}
 
-			goto error;
-		}
+	// Done
+	if (eepromJob.slot >= 0)
+	{
+		configSlot = eepromJob.slot;
+		configSeq = eepromJob.seq;
 	}
 
-	Serial.write("\xFF");
+	eepromWriterRelease();
+}
 
-done:
-	err = 0;
-error:
-	return err;
+// CRC-16/CCITT, as _crc_ccitt_update() in avr-libc
+static uint16_t crc16Update(uint16_t crc, uint8_t data)
+{
+	data ^= crc & 0xff;
+	data ^= data << 4;
+
+	return ((((uint16_t)data << 8) | (crc >> 8)) ^ (uint8_t)(data >> 4) ^ ((uint16_t)data << 3));
 }
 
-static int configStartup()
+static uint16_t crc16(uint16_t crc, const uint8_t* data, uint16_t size)
 {
-	int err = -1;
-	uint8_t* config;
-	uint16_t size;
+	unsigned i;
 
-	// Try and get config
-	if ((size = eepromLoadConfig(&config)) < 0)
+	for (i = 0; i < size; ++i)
 	{
-		Serial.println("Failed loading config on startup");
+		crc = crc16Update(crc, data[i]);
+	}
+
+	return crc;
+}
+
+// ***** CONFIG INDEX *****
+// Written right after the config objects of a slot and covered by its CRC:
+// | buttons (1) | key start (buttons + 1) | LED obj (buttons) | animation obj (buttons) | key objs |
+// Entries are object numbers, CONFIG_INDEX_NONE if a button has none. The keys
+// of button b are key objs [key start[b], key start[b + 1]), in config order.
+#define CONFIG_INDEX_NONE 0xff
+#define CONFIG_INDEX_MAX_BTNS 0xff
+
+// Key bindings a slot can hold: each takes an object and an index entry, next
+// to the smallest index, one button's (5 bytes). Key objects are numbered by
+// uint8 entries, so never CONFIG_INDEX_NONE or more.
+#define MAX_KEY_BINDINGS_SLOT ((EEPROM_CONFIG_MAX_SIZE - CONFIG_OBJARR_IDX - 5) / (CONFIG_OBJ_SIZE + 1))
+#define MAX_KEY_BINDINGS ((MAX_KEY_BINDINGS_SLOT < CONFIG_INDEX_NONE) ? MAX_KEY_BINDINGS_SLOT : (CONFIG_INDEX_NONE - 1))
+
+struct config_index_s
+{
+	uint8_t slot;
+	uint16_t addr;
+	uint8_t btnCount;
+};
+
+// Index of the config in use
+static struct config_index_s configIndex;
+
+static uint16_t configIndexSize(uint8_t btnCount, uint16_t keyNum)
+{
+	return 1 + (btnCount + 1) + btnCount * 2 + keyNum;
+}
+
+static unsigned configObjAddr(uint8_t slot, uint8_t obj)
+{
+	return EEPROM_ADDR_SLOT_CONFIG(slot) + CONFIG_OBJARR_IDX + obj * CONFIG_OBJ_SIZE;
+}
+
+// Index size of the config in slot, 0 if it does not fit
+static uint16_t eepromSlotIndexSize(uint8_t slot, uint16_t size)
+{
+	unsigned addr = EEPROM_ADDR_SLOT_CONFIG(slot) + size;
+	uint8_t btnCount;
+	uint16_t indexSize;
+
+	if (size + 1u > EEPROM_CONFIG_MAX_SIZE)
+	{
+		return 0;
+	}
+
+	btnCount = eepromReadByte(addr);
+
+	if (size + 1u + btnCount + 1u > EEPROM_CONFIG_MAX_SIZE)
+	{
+		return 0;
+	}
+
+	// Key start of the last button is the number of keys
+	indexSize = configIndexSize(btnCount, eepromReadByte(addr + 1 + btnCount));
+
+	return (size + indexSize <= EEPROM_CONFIG_MAX_SIZE) ? indexSize : 0;
+}
+
+// Is slot's header intact and does its CRC match the content?
+static bool eepromSlotValid(uint8_t slot, uint16_t* seq, uint16_t* size)
+{
+	uint16_t crc = 0xffff;
+	uint16_t indexSize;
+	unsigned i;
+
+	if (eepromReadHWord(EEPROM_ADDR_SLOT_MAGIC(slot)) != EEPROM_SLOT_MAGIC)
+	{
+		return false;
+	}
+
+	*seq = eepromReadHWord(EEPROM_ADDR_SLOT_SEQ(slot));
+	*size = eepromReadHWord(EEPROM_ADDR_SLOT_SIZE(slot));
+
+	if ((indexSize = eepromSlotIndexSize(slot, *size)) == 0)
+	{
+		return false;
+	}
+
+	// Covers seq, size, the config and its index
+	for (i = EEPROM_ADDR_SLOT_SEQ(slot); i < EEPROM_ADDR_SLOT_CRC(slot); ++i)
+	{
+		crc = crc16Update(crc, eepromReadByte(i));
+	}
+
+	for (i = 0; i < *size + indexSize; ++i)
+	{
+		crc = crc16Update(crc, eepromReadByte(EEPROM_ADDR_SLOT_CONFIG(slot) + i));
+	}
+
+	return crc == eepromReadHWord(EEPROM_ADDR_SLOT_CRC(slot));
+}
+
+// Pick the newest valid slot
+static void eepromFindConfig()
+{
+	uint16_t seq;
+	uint16_t size;
+	uint8_t slot;
+
+	configSlot = -1;
+
+	for (slot = 0; slot < EEPROM_SLOTS; ++slot)
+	{
+		if (!eepromSlotValid(slot, &seq, &size))
+		{
+			continue;
+		}
+
+		// Sequence numbers wrap around
+		if ((configSlot < 0) || ((int16_t)(seq - configSeq) > 0))
+		{
+			configSlot = slot;
+			configSeq = seq;
+		}
+	}
+}
+
+static bool eepromHasConfig()
+{
+	return configSlot >= 0;
+}
+
+static bool isConfigured()
+{
+	return configured;
+}
+
+static uint8_t eepromTopologyChecksum(uint8_t count, uint8_t base)
+{
+	return ~((EEPROM_TOPOLOGY_MAGIC & 0xff) + (EEPROM_TOPOLOGY_MAGIC >> 8) + count + base);
+}
+
+static void eepromStoreTopology(uint8_t count, uint8_t base)
+{
+	// Unchanged chain - Don't wear the cells on every boot
+	eepromUpdateByte(EEPROM_ADDR_TOPOLOGY_MAGIC + 0, EEPROM_TOPOLOGY_MAGIC & 0xff);
+	eepromUpdateByte(EEPROM_ADDR_TOPOLOGY_MAGIC + 1, EEPROM_TOPOLOGY_MAGIC >> 8);
+	eepromUpdateByte(EEPROM_ADDR_TOPOLOGY_COUNT, count);
+	eepromUpdateByte(EEPROM_ADDR_TOPOLOGY_BASE, base);
+	eepromUpdateByte(EEPROM_ADDR_TOPOLOGY_CHECKSUM, eepromTopologyChecksum(count, base));
+}
+
+static int eepromLoadTopology(uint8_t* count, uint8_t* base)
+{
+	int err = -1;
+
+	if (eepromReadHWord(EEPROM_ADDR_TOPOLOGY_MAGIC) != EEPROM_TOPOLOGY_MAGIC)
+	{
+		goto error;
+	}
+
+	*count = eepromReadByte(EEPROM_ADDR_TOPOLOGY_COUNT);
+	*base = eepromReadByte(EEPROM_ADDR_TOPOLOGY_BASE);
+
+	if (eepromReadByte(EEPROM_ADDR_TOPOLOGY_CHECKSUM) != eepromTopologyChecksum(*count, *base))
+	{
+		goto error;
+	}
+
+	err = 0;
+error:
+	return err;
+}
+
+// Keys of btnIdx are key objs [*first, *first + count)
+static uint8_t configIndexKeys(uint8_t btnIdx, uint8_t* first)
+{
+	unsigned addr = configIndex.addr + 1 + btnIdx;
+
+	if (btnIdx >= configIndex.btnCount)
+	{
+		return 0;
+	}
+
+	*first = eepromReadByte(addr);
+
+	return eepromReadByte(addr + 1) - *first;
+}
+
+static void configIndexKey(uint8_t key, struct key_cfg_s* cfg)
+{
+	uint8_t obj = eepromReadByte(configIndex.addr + 1 + (configIndex.btnCount + 1) + configIndex.btnCount * 2 + key);
+	unsigned addr = configObjAddr(configIndex.slot, obj) + CONFIG_OBJ_DATA_OFFSET;
+
+	cfg->keyValue = eepromReadByte(addr + CONFIG_OBJ_KEYVAL_IDX);
+	cfg->pressType = (eepromReadByte(addr + CONFIG_OBJ_KEYVAL_PRESS_TYPE) == 0) ? BTN_PRESS_TYPE_ONCE : BTN_PRESS_TYPE_CONT;
+}
+
+// The last object of type (LED or animation) of btnIdx
+static uint8_t configIndexObj(uint8_t btnIdx, uint8_t type)
+{
+	unsigned addr = configIndex.addr + 1 + (configIndex.btnCount + 1) + btnIdx;
+
+	if (btnIdx >= configIndex.btnCount)
+	{
+		return CONFIG_INDEX_NONE;
+	}
+
+	if (type == CONFIG_ANIMATION)
+	{
+		addr += configIndex.btnCount;
+	}
+
+	return eepromReadByte(addr);
+}
+
+static void configReadColor(uint8_t obj, struct led_obj_s* color)
+{
+	unsigned addr = configObjAddr(configIndex.slot, obj) + CONFIG_OBJ_DATA_OFFSET;
+
+	color->ledR = eepromReadByte(addr + CONFIG_OBJ_LED_R_IDX);
+	color->ledG = eepromReadByte(addr + CONFIG_OBJ_LED_G_IDX);
+	color->ledB = eepromReadByte(addr + CONFIG_OBJ_LED_B_IDX);
+}
+
+static uint8_t configReadAnimation(uint8_t obj, struct led_obj_s* color)
+{
+	configReadColor(obj, color);
+
+	return eepromReadByte(configObjAddr(configIndex.slot, obj) + CONFIG_OBJ_DATA_OFFSET + CONFIG_OBJ_LED_ANIMATION);
+}
+
+#ifndef CONFIG_XIP
+#define BTN_COLOR_NONE 0xff
+
+// Index of color in btnColors, added if no button had it yet.
+// BTN_COLOR_NONE if the table can't grow.
+static uint8_t btnColorIndex(const struct led_obj_s* color)
+{
+	struct led_obj_s* nucolors;
+	uint8_t i;
+
+	for (i = 0; i < btnColorNum; ++i)
+	{
+		if (memcmp(&btnColors[i], color, sizeof(struct led_obj_s)) == 0)
+		{
+			return i;
+		}
+	}
+
+	if (btnColorNum == BTN_COLOR_NONE)
+	{
+		return BTN_COLOR_NONE;
+	}
+
+	nucolors = (struct led_obj_s*)realloc(btnColors, sizeof(struct led_obj_s) * (btnColorNum + 1));
+
+	if (!nucolors)
+	{
+		return BTN_COLOR_NONE;
+	}
+
+	btnColors = nucolors;
+	btnColors[btnColorNum] = *color;
+
+	return btnColorNum++;
+}
+#endif
+
+// Switch to the config committed in slot - Only its index is looked at
+static int parseConfig(uint8_t slot)
+{
+	int err = -1;
+	uint16_t size = eepromReadHWord(EEPROM_ADDR_SLOT_SIZE(slot));
+#ifndef CONFIG_XIP
+	struct key_cfg_s* nukeys;
+	struct led_obj_s color;
+	uint8_t keyNum = 0;
+	uint8_t first;
+	uint8_t obj;
+	size_t i;
+	unsigned j;
+#endif
+
+	// Check magic
+	if (eepromReadHWord(EEPROM_ADDR_SLOT_CONFIG(slot) + CONFIG_MAGIC_IDX) != CONFIG_BEGIN)
+	{
+		Serial.println("Error parsing config: Invalid magic.");
+
+		goto error;
+	}
+
+	configIndex.slot = slot;
+	configIndex.addr = EEPROM_ADDR_SLOT_CONFIG(slot) + size;
+	configIndex.btnCount = eepromReadByte(configIndex.addr);
+
+#ifndef CONFIG_XIP
+	// Only keys of connected buttons are loaded
+	for (i = 0; i < btnNum; ++i)
+	{
+		keyNum += configIndexKeys(i, &first);
+	}
+
+	if (keyNum > MAX_KEY_BINDINGS)
+	{
+		Serial.println("Error parsing config: Too many keys.");
+
+		goto error;
+	}
+
+	nukeys = (struct key_cfg_s*)realloc(btnKeys, sizeof(struct key_cfg_s) * keyNum);
+
+	if ((!nukeys) && (keyNum))
+	{
+		goto error;
+	}
+
+	btnKeys = nukeys;
+
+	// Reset previous keys/led/animation configs
+	memset(btnConfig, 0, sizeof(struct btn_cfg_s) * btnNum);
+	btnColorNum = 0;
+
+	for (i = 0, keyNum = 0; i < btnNum; ++i)
+	{
+		struct btn_cfg_s* btn = &btnConfig[i];
+
+		btn->keyHead = keyNum;
+		btn->keyCount = configIndexKeys(i, &first);
+
+		for (j = 0; j < btn->keyCount; ++j)
+		{
+			configIndexKey(first + j, &btnKeys[keyNum++]);
+		}
+
+		if ((obj = configIndexObj(i, CONFIG_LED)) != CONFIG_INDEX_NONE)
+		{
+			configReadColor(obj, &color);
+
+			if ((btn->clickColor = btnColorIndex(&color)) == BTN_COLOR_NONE)
+			{
+				goto error_colors;
+			}
+
+			btn->flags |= BTN_CONFIG_CLICK_COLOR;
+		}
+
+		if ((obj = configIndexObj(i, CONFIG_ANIMATION)) != CONFIG_INDEX_NONE)
+		{
+			uint8_t type = configReadAnimation(obj, &color);
+
+			// Unknown animations show as unconfigured
+			if (type <= BTN_CONFIG_ANIMATION_TYPE)
+			{
+				if ((btn->animationColor = btnColorIndex(&color)) == BTN_COLOR_NONE)
+				{
+					goto error_colors;
+				}
+
+				btn->flags |= BTN_CONFIG_ANIMATION | type;
+			}
+		}
+	}
+#endif
+
+	configured = true;
+
+	err = 0;
+error:
+	return err;
+
+#ifndef CONFIG_XIP
+error_colors:
+	Serial.println("Error parsing config: No RAM for its colors.");
+
+	// Buttons were already reset, half a config is no config
+	configured = false;
+
+	return err;
+#endif
+}
+
+// ***** CONFIG ACCESS *****
+static uint8_t btnKeyCount(uint8_t btnIdx)
+{
+#ifdef CONFIG_XIP
+	uint8_t first;
+
+	return configIndexKeys(btnIdx, &first);
+#else
+	return btnConfig[btnIdx].keyCount;
+#endif
+}
+
+static void btnKey(uint8_t btnIdx, uint8_t i, struct key_cfg_s* key)
+{
+#ifdef CONFIG_XIP
+	uint8_t first;
+
+	configIndexKeys(btnIdx, &first);
+	configIndexKey(first + i, key);
+#else
+	*key = btnKeys[btnConfig[btnIdx].keyHead + i];
+#endif
+}
+
+static bool btnClickColor(uint8_t btnIdx, struct led_obj_s* color)
+{
+#ifdef CONFIG_XIP
+	uint8_t obj = configIndexObj(btnIdx, CONFIG_LED);
+
+	if (obj == CONFIG_INDEX_NONE)
+	{
+		return false;
+	}
+
+	configReadColor(obj, color);
+#else
+	if (!(btnConfig[btnIdx].flags & BTN_CONFIG_CLICK_COLOR))
+	{
+		return false;
+	}
+
+	*color = btnColors[btnConfig[btnIdx].clickColor];
+#endif
+
+	return true;
+}
+
+// Animation type of btnIdx, ANIMATION_NONE if it has none
+static uint8_t btnAnimation(uint8_t btnIdx, struct led_obj_s* color)
+{
+#ifdef CONFIG_XIP
+	uint8_t obj = configIndexObj(btnIdx, CONFIG_ANIMATION);
+
+	if (obj == CONFIG_INDEX_NONE)
+	{
+		return ANIMATION_NONE;
+	}
+
+	return configReadAnimation(obj, color);
+#else
+	if (!(btnConfig[btnIdx].flags & BTN_CONFIG_ANIMATION))
+	{
+		return ANIMATION_NONE;
+	}
+
+	*color = btnColors[btnConfig[btnIdx].animationColor];
+
+	return btnConfig[btnIdx].flags & BTN_CONFIG_ANIMATION_TYPE;
+#endif
+}
+
+// ***** ANIMATION CLASSES *****
+// Buttons showing the same animation in the same color share a class, which
+// is rendered once per frame. Gradient depends on the button's wheel offset,
+// so it is always rendered per button.
+#define ANIMATION_CLASSES_MAX 16
+#define ANIMATION_CLASS_NONE 0xff
+
+struct animation_class_s
+{
+	uint8_t type;
+	struct led_obj_s color;
+	RgbColor frame;
+};
+
+static struct animation_class_s animClasses[ANIMATION_CLASSES_MAX];
+static uint8_t animClassNum = 0;
+
+static uint8_t animationClassFind(uint8_t type, const struct led_obj_s* color)
+{
+	uint8_t i;
+
+	for (i = 0; i < animClassNum; ++i)
+	{
+		struct animation_class_s* cls = &animClasses[i];
+
+		if ((cls->type == type) && (!memcmp(&cls->color, color, sizeof(*color))))
+		{
+			return i;
+		}
+	}
+
+	// Buttons past the last class are rendered on their own
+	if (animClassNum == ANIMATION_CLASSES_MAX)
+	{
+		return ANIMATION_CLASS_NONE;
+	}
+
+	animClasses[animClassNum].type = type;
+	animClasses[animClassNum].color = *color;
+
+	return animClassNum++;
+}
+
+// Group the buttons of the config just loaded
+static void animationClassesBuild()
+{
+	struct led_obj_s color;
+	uint8_t type;
+	uint8_t i;
+
+	animClassNum = 0;
+
+	for (i = 0; i < btnNum; ++i)
+	{
+		type = btnAnimation(i, &color);
+
+		if ((type == ANIMATION_PULSE) || (type == ANIMATION_STILL))
+		{
+			btnRuntime[i].animClass = animationClassFind(type, &color);
+		}
+		else
+		{
+			btnRuntime[i].animClass = ANIMATION_CLASS_NONE;
+		}
+	}
+}
+
+// ***** CONFIG INGEST *****
+// An upload is checked as it streams in and written through to the free slot
+// MAX_BUFFER_DATA bytes at a time. The index is then built from what was
+// written, and the header is written last to commit it all. RAM use does not
+// depend on the config size.
+// While the upload matches the config in use, chunks are only compared with it.
+// The matched part is copied over at the first difference, and an upload that
+// matches all through is taken without writing anything.
+enum config_index_part_e
+{
+	CONFIG_INDEX_PART_COUNT = 0,
+	CONFIG_INDEX_PART_KEY_START,
+	CONFIG_INDEX_PART_LED,
+	CONFIG_INDEX_PART_ANIMATION,
+	CONFIG_INDEX_PART_KEYS
+};
+
+struct config_ingest_s
+{
+	int8_t slot;
+	uint16_t seq;
+	uint16_t size;
+	uint16_t received;
+	uint16_t written;
+	uint16_t crc;
+	uint16_t objnum;
+	uint16_t keyNum;
+	uint8_t btnCount;
+	uint8_t objType;
+	uint8_t chunkLen;
+	bool committing;
+
+	// Compared with the config in use rather than written, then the first
+	// matched bytes copied over once a chunk differs. Its size is read from
+	// the slot by configIngestRun(), once the EEPROM is free.
+	bool matching;
+	bool sizeChecked;
+	uint16_t matched;
+	uint16_t copied;
+
+	// Index generation
+	uint16_t indexSize;
+	uint8_t indexPart;
+	uint8_t indexBtn;
+	uint8_t indexObj;
+	uint8_t indexKeys;
+
+	uint8_t chunk[MAX_BUFFER_DATA];
+	uint8_t copy[MAX_BUFFER_DATA];
+	uint8_t header[EEPROM_SLOT_HEADER_SIZE];
+};
+
+static struct config_ingest_s configIngest;
+
+static int configIngestBegin(uint16_t size)
+{
+	int err = -1;
+
+	// Whole objects, and at least the config header
+	if ((size < CONFIG_OBJARR_IDX) || (size > EEPROM_CONFIG_MAX_SIZE) || ((size - CONFIG_OBJARR_IDX) % CONFIG_OBJ_SIZE))
+	{
+		goto error;
+	}
+
+	// The slot not holding the current config
+	configIngest.slot = eepromHasConfig() ? (configSlot + 1) % EEPROM_SLOTS : 0;
+	configIngest.seq = configSeq + 1;
+	configIngest.size = size;
+	configIngest.received = 0;
+	configIngest.written = 0;
+	configIngest.keyNum = 0;
+	configIngest.btnCount = 0;
+	configIngest.chunkLen = 0;
+	configIngest.committing = false;
+	configIngest.sizeChecked = false;
+	configIngest.matched = 0;
+	configIngest.copied = 0;
+	configIngest.indexSize = 0;
+	configIngest.indexPart = CONFIG_INDEX_PART_COUNT;
+
+	configIngest.header[0] = (EEPROM_SLOT_MAGIC & 0x00ff) >> 0;
+	configIngest.header[1] = (EEPROM_SLOT_MAGIC & 0xff00) >> 8;
+	configIngest.header[2] = (configIngest.seq & 0x00ff) >> 0;
+	configIngest.header[3] = (configIngest.seq & 0xff00) >> 8;
+	configIngest.header[4] = (size & 0x00ff) >> 0;
+	configIngest.header[5] = (size & 0xff00) >> 8;
+
+	configIngest.crc = crc16(0xffff, configIngest.header + 2, 4);
+
+	// A config in use, and no commit of it still going on
+	configIngest.matching = (eepromHasConfig()) && ((!eepromWriterBusy()) || (eepromJob.slot < 0));
+
+	err = 0;
+error:
+	return err;
+}
+
+// Can another byte be taken?
+static bool configIngestReady()
+{
+	return (configIngest.chunkLen < MAX_BUFFER_DATA) && (!eepromWriterBusyWith(configIngest.chunk));
+}
+
+static int configIngestByte(uint8_t c)
+{
+	int err = -1;
+	uint16_t pos = configIngest.received++;
+
+	configIngest.chunk[configIngest.chunkLen++] = c;
+	configIngest.crc = crc16Update(configIngest.crc, c);
+
+	if (pos == CONFIG_OBJARR_IDX - 1)
+	{
+		// The whole config header is in the first chunk
+		uint16_t magic = (configIngest.chunk[CONFIG_MAGIC_IDX + 0] << 0) | (configIngest.chunk[CONFIG_MAGIC_IDX + 1] << 8);
+
+		configIngest.objnum = (configIngest.chunk[CONFIG_OBJNUM_IDX + 0] << 0) | (configIngest.chunk[CONFIG_OBJNUM_IDX + 1] << 8);
+
+		// Object numbers must fit an index entry
+		if ((magic != CONFIG_BEGIN) || (configIngest.size != CONFIG_OBJARR_IDX + CONFIG_OBJ_SIZE * configIngest.objnum) ||
+			(configIngest.objnum >= CONFIG_INDEX_NONE))
+		{
+			goto error;
+		}
+	}
+	else if (pos >= CONFIG_OBJARR_IDX)
+	{
+		uint8_t off = (pos - CONFIG_OBJARR_IDX) % CONFIG_OBJ_SIZE;
+
+		if (off == CONFIG_OBJ_TYPE_OFFSET)
+		{
+			configIngest.objType = c;
+		}
+		else if ((off == CONFIG_OBJ_BTN_IDX_OFFSET) && (c < CONFIG_INDEX_MAX_BTNS))
+		{
+			if (c >= configIngest.btnCount)
+			{
+				configIngest.btnCount = c + 1;
+			}
+
+			// Would not fit in RAM once loaded
+			if ((configIngest.objType == CONFIG_KEY) && (++configIngest.keyNum > MAX_KEY_BINDINGS))
+			{
+				goto error;
+			}
+		}
+	}
+
+	err = 0;
+error:
+	return err;
+}
+
+// Last object of type for btnIdx among the ones written to the slot
+static uint8_t configIngestFindObj(uint8_t btnIdx, uint8_t type)
+{
+	uint8_t found = CONFIG_INDEX_NONE;
+	uint8_t obj;
+
+	for (obj = 0; obj < configIngest.objnum; ++obj)
+	{
+		unsigned addr = configObjAddr(configIngest.slot, obj);
+
+		if ((eepromReadByte(addr + CONFIG_OBJ_TYPE_OFFSET) == type) && (eepromReadByte(addr + CONFIG_OBJ_BTN_IDX_OFFSET) == btnIdx))
+		{
+			found = obj;
+		}
+	}
+
+	return found;
+}
+
+// Next byte of the index, from the objects already in the slot
+static uint8_t configIngestIndexByte()
+{
+	uint8_t c = CONFIG_INDEX_NONE;
+
+	switch (configIngest.indexPart)
+	{
+		case CONFIG_INDEX_PART_COUNT:
+		{
+			c = configIngest.btnCount;
+
+			configIngest.indexPart = CONFIG_INDEX_PART_KEY_START;
+			configIngest.indexBtn = 0;
+			configIngest.indexKeys = 0;
+
+			break;
+		}
+
+		case CONFIG_INDEX_PART_KEY_START:
+		{
+			c = configIngest.indexKeys;
+
+			if (configIngest.indexBtn == configIngest.btnCount)
+			{
+				configIngest.indexPart = CONFIG_INDEX_PART_LED;
+				configIngest.indexBtn = 0;
+
+				break;
+			}
+
+			// Keys of this button come right before the next one's
+			for (uint8_t obj = 0; obj < configIngest.objnum; ++obj)
+			{
+				unsigned addr = configObjAddr(configIngest.slot, obj);
+
+				if ((eepromReadByte(addr + CONFIG_OBJ_TYPE_OFFSET) == CONFIG_KEY) &&
+					(eepromReadByte(addr + CONFIG_OBJ_BTN_IDX_OFFSET) == configIngest.indexBtn))
+				{
+					configIngest.indexKeys++;
+				}
+			}
+
+			configIngest.indexBtn++;
+
+			break;
+		}
+
+		case CONFIG_INDEX_PART_LED:
+		case CONFIG_INDEX_PART_ANIMATION:
+		{
+			uint8_t type = (configIngest.indexPart == CONFIG_INDEX_PART_LED) ? CONFIG_LED : CONFIG_ANIMATION;
+
+			c = configIngestFindObj(configIngest.indexBtn, type);
+
+			if (++configIngest.indexBtn == configIngest.btnCount)
+			{
+				configIngest.indexPart++;
+				configIngest.indexBtn = 0;
+				configIngest.indexObj = 0;
+			}
+
+			break;
+		}
+
+		case CONFIG_INDEX_PART_KEYS:
+		{
+			// Next key object of the button, in config order
+			while (configIngest.indexBtn < configIngest.btnCount)
+			{
+				while (configIngest.indexObj < configIngest.objnum)
+				{
+					uint8_t obj = configIngest.indexObj++;
+					unsigned addr = configObjAddr(configIngest.slot, obj);
+
+					if ((eepromReadByte(addr + CONFIG_OBJ_TYPE_OFFSET) == CONFIG_KEY) &&
+						(eepromReadByte(addr + CONFIG_OBJ_BTN_IDX_OFFSET) == configIngest.indexBtn))
+					{
+						return obj;
+					}
+				}
+
+				configIngest.indexBtn++;
+				configIngest.indexObj = 0;
+			}
+
+			break;
+		}
+	}
+
+	return c;
+}
+
+// Does the chunk hold what the config in use has at the same place?
+// Returns 1 if so, 0 if not, -1 if not decided yet as the EEPROM is busy.
+static int configIngestChunkMatches()
+{
+	unsigned addr = EEPROM_ADDR_SLOT_CONFIG(configSlot) + configIngest.written;
+	uint8_t i;
+
+	// Don't stall the loop on a write in progress
+	if (!eeprom_is_ready())
+	{
+		return -1;
+	}
+
+	for (i = 0; i < configIngest.chunkLen; ++i)
+	{
+		if (eepromReadByte(addr + i) != configIngest.chunk[i])
+		{
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+// Push the upload along. Returns 1 while in progress, 0 once committed.
+static int configIngestRun()
+{
+	int err = -1;
+	uint16_t total = configIngest.size + configIngest.indexSize;
+
+	// Previous chunk, copy or the header still being written
+	if ((eepromWriterBusyWith(configIngest.chunk)) || (eepromWriterBusyWith(configIngest.copy)) ||
+		(eepromWriterBusyWith(configIngest.header)))
+	{
+		return 1;
+	}
+
+	// Only a config of the same size can match
+	if ((configIngest.matching) && (!configIngest.sizeChecked))
+	{
+		if (!eeprom_is_ready())
+		{
+			return 1;
+		}
+
+		configIngest.matching = (eepromReadHWord(EEPROM_ADDR_SLOT_SIZE(configSlot)) == configIngest.size);
+		configIngest.sizeChecked = true;
+	}
+
+	// The matched bytes go over first, a chunk at a time
+	if (configIngest.copied < configIngest.matched)
+	{
+		uint16_t n = min((uint16_t)(configIngest.matched - configIngest.copied), (uint16_t)MAX_BUFFER_DATA);
+		uint8_t i;
+
+		if (!eeprom_is_ready())
+		{
+			return 1;
+		}
+
+		for (i = 0; i < n; ++i)
+		{
+			configIngest.copy[i] = eepromReadByte(EEPROM_ADDR_SLOT_CONFIG(configSlot) + configIngest.copied + i);
+		}
+
+		eepromWriterStart(configIngest.copy, EEPROM_ADDR_SLOT_CONFIG(configIngest.slot) + configIngest.copied, n);
+
+		configIngest.copied += n;
+
+		return 1;
+	}
+
+	// Same config as the one in use - Nothing to write
+	if ((configIngest.matching) && (configIngest.written == configIngest.size))
+	{
+		return 0;
+	}
+
+	// Committed once the header's last byte is programmed
+	if (configIngest.committing)
+	{
+		return eeprom_is_ready() ? 0 : 1;
+	}
+
+	// Config bytes are in - Build the index from them
+	if ((configIngest.written == configIngest.size) && (configIngest.indexSize == 0))
+	{
+		configIngest.indexSize = configIndexSize(configIngest.btnCount, configIngest.keyNum);
+
+		if (configIngest.size + configIngest.indexSize > EEPROM_CONFIG_MAX_SIZE)
+		{
+			Serial.println("Error parsing config: Too large with its index.");
+
+			goto error;
+		}
+
+		total = configIngest.size + configIngest.indexSize;
+	}
+
+	// The index is read back from the slot, a byte per pass as each one
+	// scans the objects
+	if ((configIngest.indexSize) && (configIngest.written + configIngest.chunkLen < total))
+	{
+		uint8_t c;
+
+		if (!eeprom_is_ready())
+		{
+			return 1;
+		}
+
+		c = configIngestIndexByte();
+
+		configIngest.chunk[configIngest.chunkLen++] = c;
+		configIngest.crc = crc16Update(configIngest.crc, c);
+	}
+
+	// Full chunk, or the last of the config or of the index
+	if ((configIngest.chunkLen == MAX_BUFFER_DATA) ||
+		((configIngest.chunkLen) && (configIngest.received == configIngest.size) &&
+		 ((configIngest.indexSize == 0) || (configIngest.written + configIngest.chunkLen == total))))
+	{
+		if (configIngest.matching)
+		{
+			int match = configIngestChunkMatches();
+
+			if (match < 0)
+			{
+				return 1;
+			}
+
+			if (match)
+			{
+				configIngest.written += configIngest.chunkLen;
+				configIngest.chunkLen = 0;
+
+				return 1;
+			}
+
+			// Differs - The config so far is the one in use, copy it over
+			configIngest.matching = false;
+			configIngest.matched = configIngest.written;
+
+			return 1;
+		}
+
+		eepromWriterStart(configIngest.chunk, EEPROM_ADDR_SLOT_CONFIG(configIngest.slot) + configIngest.written, configIngest.chunkLen);
+
+		configIngest.written += configIngest.chunkLen;
+		configIngest.chunkLen = 0;
+
+		return 1;
+	}
+
+	if ((configIngest.indexSize == 0) || (configIngest.written < total))
+	{
+		return 1;
+	}
+
+	// All config and index bytes are in - The header makes the slot valid
+	configIngest.header[6] = (configIngest.crc & 0x00ff) >> 0;
+	configIngest.header[7] = (configIngest.crc & 0xff00) >> 8;
+
+	eepromWriterStart(configIngest.header, EEPROM_ADDR_SLOT(configIngest.slot), EEPROM_SLOT_HEADER_SIZE, configIngest.slot, configIngest.seq);
+
+	configIngest.committing = true;
+
+	return 1;
+error:
+	return err;
+}
+
+static void configIngestAbort()
+{
+	if ((eepromWriterBusyWith(configIngest.chunk)) || (eepromWriterBusyWith(configIngest.header)))
+	{
+		eepromWriterRelease();
+	}
+}
+
+// Inter-byte timeout of a request in progress
+#define TIMEOUT_MS 1000
+
+// Bound the time a single loop() spends on serial
+#define SERIAL_MAX_BYTES_PER_LOOP 64
+
+// Serial requests are parsed as bytes arrive, so loop() never waits on the host:
+// | 0x42 | magic (2) | [ size (2) | config (size) ] |
+enum serial_state_e
+{
+	SERIAL_STATE_IDLE = 0,
+	SERIAL_STATE_MAGIC,
+	SERIAL_STATE_CONFIG_SIZE,
+	SERIAL_STATE_CONFIG_DATA,
+	SERIAL_STATE_CONFIG_COMMIT
+};
+
+struct serial_parser_s
+{
+	enum serial_state_e state;
+	uint8_t field[2];
+	uint8_t fieldLen;
+	unsigned long lastByteMillis;
+};
+
+static struct serial_parser_s serialParser = { SERIAL_STATE_IDLE, { 0, 0 }, 0, 0 };
+
+static void serialParserReset()
+{
+	if ((serialParser.state == SERIAL_STATE_CONFIG_DATA) || (serialParser.state == SERIAL_STATE_CONFIG_COMMIT))
+	{
+		configIngestAbort();
+	}
+
+	serialParser.state = SERIAL_STATE_IDLE;
+	serialParser.fieldLen = 0;
+}
+
+// Collect a 2 byte little endian field. True once complete.
+static bool serialParserField(uint8_t c, uint16_t* value)
+{
+	serialParser.field[serialParser.fieldLen++] = c;
+
+	if (serialParser.fieldLen < sizeof(serialParser.field))
+	{
+		return false;
+	}
+
+	*value = (serialParser.field[0] << 0) | (serialParser.field[1] << 8);
+	serialParser.fieldLen = 0;
+
+	return true;
+}
+
+// The upload is committed to its slot - Apply it
+static int handleRecvConfig()
+{
+	int err = -1;
+
+	// Parse the config
+	if (parseConfig(configSlot) < 0)
+	{
+		Serial.println("Error parsing config");
 
-		// No config available
 		goto error;
 	}
 
-	// Parse the config
-	if (parseConfig(config, size) < 0)
+	animationClassesBuild();
+
+	err = 0;
+error:
+	return err;
+}
+
+// Handle a request once its magic arrived.
+// Returns 1 if it carries a payload still to come.
+static int handleSerialCommand(uint16_t magic)
+{
+	int err = -1;
+
+	// Verify magic
+	switch (magic)
+	{
+		case SERIAL_RECV_CONFIG_MAGIC:
+		{
+			serialParser.state = SERIAL_STATE_CONFIG_SIZE;
+
+			return 1;
+		}
+
+		case SERIAL_SEND_CONNECTED_MODULES:
+		{
+			// Send number of connected modules (max 255)
+			Serial.write((uint8_t*)&btnNum, 1);
+
+			break;
+		}
+
+		case SERIAL_SEND_EVENT_STATS:
+		{
+			uint16_t overflows;
+			uint16_t invalid;
+			uint32_t maxLatency = btnEventsMaxLatency;
+
+			// Counters are updated from the ISR
+			noInterrupts();
+			overflows = btnEventsOverflows;
+			invalid = btnEventsInvalid;
+			interrupts();
+
+			// | overflows (2) | invalid addrs (2) | max queue depth (1) | max latency us (4) |
+			Serial.write((uint8_t*)&overflows, sizeof(overflows));
+			Serial.write((uint8_t*)&invalid, sizeof(invalid));
+			Serial.write(&btnEventsMaxDepth, sizeof(btnEventsMaxDepth));
+			Serial.write((uint8_t*)&maxLatency, sizeof(maxLatency));
+
+			// Peaks restart with every query
+			btnEventsMaxDepth = 0;
+			btnEventsMaxLatency = 0;
+
+			break;
+		}
+
+#ifndef PAWS_RELEASE
+		case SERIAL_SEND_LOOP_STATS:
+		{
+			uint16_t isrEntries;
+			uint16_t ledGapMaxUs;
+			uint16_t ledGapOverruns;
+			unsigned j;
+
+			// Updated from the ISR
+			noInterrupts();
+			isrEntries = loopStatsIsrEntries;
+			loopStatsIsrEntries = 0;
+			interrupts();
+
+			// | loops (4) | period total us (4) | period max us (2) | period bins (4 each) |
+			// | per stage: total us (4) | per stage: max us (2) | Show() calls (2) | ISR entries (2) |
+			// | max LED chunk gap us (2) | LED gap overruns (2) |
+			Serial.write((uint8_t*)&loopStats.loops, sizeof(loopStats.loops));
+			Serial.write((uint8_t*)&loopStats.periodTotalUs, sizeof(loopStats.periodTotalUs));
+			Serial.write((uint8_t*)&loopStats.periodMaxUs, sizeof(loopStats.periodMaxUs));
+			Serial.write((uint8_t*)loopStats.periodBins, sizeof(loopStats.periodBins));
+
+			for (j = 0; j < LOOP_STAGES; ++j)
+			{
+				Serial.write((uint8_t*)&loopStats.stageTotalUs[j], sizeof(loopStats.stageTotalUs[j]));
+			}
+
+			for (j = 0; j < LOOP_STAGES; ++j)
+			{
+				Serial.write((uint8_t*)&loopStats.stageMaxUs[j], sizeof(loopStats.stageMaxUs[j]));
+			}
+
+			Serial.write((uint8_t*)&loopStats.shows, sizeof(loopStats.shows));
+			Serial.write((uint8_t*)&isrEntries, sizeof(isrEntries));
+
+			ledGapMaxUs = ledStrip ? ledStrip->Method().MaxGapUs() : 0;
+			ledGapOverruns = ledStrip ? ledStrip->Method().GapOverruns() : 0;
+
+			Serial.write((uint8_t*)&ledGapMaxUs, sizeof(ledGapMaxUs));
+			Serial.write((uint8_t*)&ledGapOverruns, sizeof(ledGapOverruns));
+
+			// Restart with every query
+			memset(&loopStats, 0, sizeof(loopStats));
+
+			if (ledStrip)
+			{
+				ledStrip->Method().ResetGapStats();
+			}
+
+			break;
+		}
+#endif
+
+		case SERIAL_SEND_ENUM_TIME:
+		{
+			// | enumeration time us (4) | ack polls (2) |
+			Serial.write((uint8_t*)&enumTimeUs, sizeof(uint32_t));
+			Serial.write((uint8_t*)&enumPolls, sizeof(enumPolls));
+
+			break;
+		}
+
+		case SERIAL_SEND_EEPROM_WEAR:
+		{
+			uint8_t regions = EEPROM_WEAR_REGIONS;
+
+			// | regions (1) | byte writes per region (4 each) |
+			Serial.write(&regions, sizeof(regions));
+			Serial.write((uint8_t*)eepromWear.writes, sizeof(eepromWear.writes));
+
+			break;
+		}
+
+		case SERIAL_SEND_PRESSES:
+		{
+			// Toggle
+			sendBtnPressesOverSerial = true;
+
+			break;
+		}
+
+		case SERIAL_SEND_PRESSES_RELEASE:
+		{
+			// Toggle
+			sendBtnPressesOverSerial = false;
+
+			break;
+		}
+
+		default:
+		{
+			Serial.println("Invalid serial magic number");
+
+			goto error;
+		}
+	}
+
+	Serial.write("\xFF");
+
+	err = 0;
+error:
+	return err;
+}
+
+static void handleSerialByte(uint8_t c)
+{
+	uint16_t value;
+
+	switch (serialParser.state)
+	{
+		case SERIAL_STATE_IDLE:
+		{
+			// Read data request
+			if (c != 0x42)
+			{
+				break;
+			}
+
+			// Write magic number so desktop can identify this as the correct port
+			Serial.write("\x42\x69");
+
+			serialParser.state = SERIAL_STATE_MAGIC;
+
+			break;
+		}
+
+		case SERIAL_STATE_MAGIC:
+		{
+			if (!serialParserField(c, &value))
+			{
+				break;
+			}
+
+			if (handleSerialCommand(value) != 1)
+			{
+				serialParserReset();
+			}
+
+			break;
+		}
+
+		case SERIAL_STATE_CONFIG_SIZE:
+		{
+			if (!serialParserField(c, &value))
+			{
+				break;
+			}
+
+			if (configIngestBegin(value) < 0)
+			{
+				Serial.println("Invalid config");
+
+				serialParserReset();
+
+				break;
+			}
+
+			serialParser.state = SERIAL_STATE_CONFIG_DATA;
+
+			break;
+		}
+
+		case SERIAL_STATE_CONFIG_DATA:
+		{
+			if (configIngestByte(c) < 0)
+			{
+				Serial.println("Invalid config");
+
+				serialParserReset();
+
+				break;
+			}
+
+			// Everything received, wait for the commit
+			if (configIngest.received == configIngest.size)
+			{
+				serialParser.state = SERIAL_STATE_CONFIG_COMMIT;
+			}
+
+			break;
+		}
+
+		case SERIAL_STATE_CONFIG_COMMIT:
+		{
+			break;
+		}
+	}
+}
+
+// Is the parser ready for another byte?
+static bool serialParserReady()
+{
+	switch (serialParser.state)
+	{
+		case SERIAL_STATE_CONFIG_DATA:
+		{
+			return configIngestReady();
+		}
+
+		case SERIAL_STATE_CONFIG_COMMIT:
+		{
+			return false;
+		}
+
+		default:
+		{
+			return true;
+		}
+	}
+}
+
+// Config upload in progress - Write it through, then apply it
+static void handleSerialIngest()
+{
+	int err;
+
+	if ((serialParser.state != SERIAL_STATE_CONFIG_DATA) && (serialParser.state != SERIAL_STATE_CONFIG_COMMIT))
+	{
+		return;
+	}
+
+	err = configIngestRun();
+
+	// Waiting on our own writes, not on the host
+	if ((!serialParserReady()) || (serialParser.state == SERIAL_STATE_CONFIG_COMMIT))
+	{
+		serialParser.lastByteMillis = millis();
+	}
+
+	if (err < 0)
+	{
+		Serial.println("Invalid config");
+
+		serialParserReset();
+
+		return;
+	}
+
+	if ((err != 0) || (serialParser.state != SERIAL_STATE_CONFIG_COMMIT))
+	{
+		return;
+	}
+
+	if (handleRecvConfig() < 0)
+	{
+		Serial.println("Invalid config");
+	}
+	else
+	{
+		Serial.write("\xFF");
+	}
+
+	serialParserReset();
+}
+
+// Consume what the host sent so far - Never waits for more
+static void handleSerialConfig()
+{
+	unsigned n = 0;
+
+	handleSerialIngest();
+
+	while ((Serial.available()) && (n++ < SERIAL_MAX_BYTES_PER_LOOP) && (serialParserReady()))
 	{
-		Serial.println("Error parsing config on startup");
+		handleSerialByte(Serial.read());
 
-		goto error;
+		serialParser.lastByteMillis = millis();
 	}
 
-	// Free buffer
-	free(config);
+	// Host went quiet mid request
+	if ((serialParser.state != SERIAL_STATE_IDLE) && (millis() - serialParser.lastByteMillis >= TIMEOUT_MS))
+	{
+		Serial.println("Error receiving serial request");
 
-	err = 0;
-error:
-	return err;
+		serialParserReset();
+	}
 }
 
-static void dataHandler(int size)
+static int configStartup()
 {
-	// Wait for the data
-	while (Wire.available() < 1)
-		;
+	int err = -1;
 
-	// Get the addr
-	uint8_t data = Wire.read();
-	uint8_t addrRecvd = data & 0b01111111;
-	enum btn_state_e recvState = (data & 0b10000000) == 0 ? BTN_STATE_RELEASED : BTN_STATE_PRESSED;
+	// Parse the config straight from its slot
+	if (parseConfig(configSlot) < 0)
+	{
+		Serial.println("Error parsing config on startup");
 
-	if (btnStates[addrRecvd] == recvState)
-		return;
+		goto error;
+	}
+
+	animationClassesBuild();
 
-	btnStates[addrRecvd] = recvState;
+	err = 0;
+error:
+	return err;
 }
 
 #define I2C_BCAST_ADDR (0)
 #define I2C_MASTER_ADDR (1)
 #define MAX_ADDR_ASSIGN_RETRIES (50)
 
+// A module answers as soon as its TWI runs on the new address. Poll for that
+// instead of sleeping, starting from how long the previous module took and
+// backing off up to ENUM_POLL_MAX_US
+#define ENUM_POLL_MIN_US (50)
+#define ENUM_POLL_MAX_US (4000)
+#define ENUM_MODULE_TIMEOUT_MS (500)
+
 #define REQUESTS
 
 void I2CAddrAsignReq()
@@ -619,360 +2069,914 @@ void I2CAddrAsignReq()
 	Wire.write(assignAddr);
 }
 
+static void I2CAddrBroadcast()
+{
+	Wire.beginTransmission(I2C_BCAST_ADDR);
+	Wire.write(assignAddr);
+	Wire.endTransmission();
+}
+
+// Did the token holder take assignAddr yet?
+static bool I2CAddrAcked()
+{
+	enumPolls++;
+
+#ifdef REQUESTS
+	if (Wire.requestFrom(assignAddr, (uint8_t)1) == 0)
+	{
+		return false;
+	}
+
+	// Demand the ack to be the same address assigned
+	return Wire.read() == assignAddr;
+#else
+	Wire.beginTransmission(assignAddr);
+
+	return Wire.endTransmission() == 0;
+#endif
+}
+
+// Per-button tables are sized once, when the module count is known. If the
+// RAM isn't there the chain is refused: no button is handled or lit.
+static int I2CAddrAllocTables()
+{
+	int err = -1;
+	struct btn_runtime_s* nuruntime;
+#ifndef CONFIG_XIP
+	struct btn_cfg_s* nuconfig;
+
+	nuconfig = (struct btn_cfg_s*)realloc(btnConfig, sizeof(struct btn_cfg_s) * btnNum);
+
+	if ((!nuconfig) && (btnNum))
+	{
+		goto error;
+	}
+
+	btnConfig = nuconfig;
+	memset(btnConfig, 0, sizeof(struct btn_cfg_s) * btnNum);
+#endif
+	nuruntime = (struct btn_runtime_s*)realloc(btnRuntime, sizeof(struct btn_runtime_s) * btnNum);
+
+	if ((!nuruntime) && (btnNum))
+	{
+		goto error;
+	}
+
+	btnRuntime = nuruntime;
+	memset(btnRuntime, 0, sizeof(struct btn_runtime_s) * btnNum);
+
+	for (uint8_t i = 0; i < btnNum; ++i)
+	{
+		btnRuntime[i].phase = ((uint16_t)i << 8) / btnNum;
+		btnRuntime[i].animClass = ANIMATION_CLASS_NONE;
+	}
+
+	// Button indexes of a previous chain mean nothing now
+	keyRepeatNum = 0;
+
+	if (ledStripResize(btnNum) < 0)
+	{
+		goto error;
+	}
+
+	err = 0;
+error:
+	if (err < 0)
+	{
+		Serial.println("Not enough RAM for " + String(btnNum) + " modules");
+
+		btnNum = 0;
+		keyRepeatNum = 0;
+
+		// Whatever strip is left still has to be there to show
+		ledStripResize(0);
+	}
+
+	return err;
+}
+
+// Did a module take addr?
+static bool I2CAddrProbe(uint8_t addr)
+{
+	enumPolls++;
+
+	Wire.beginTransmission(addr);
+
+	return Wire.endTransmission() == 0;
+}
+
+// Modules keep their address over a master reset. If the chain stored on the
+// last enumeration still answers - and nothing answers past its end - reuse it.
+bool restoreI2CAddrs()
+{
+	unsigned long startUs = micros();
+	uint8_t count;
+	uint8_t base;
+	unsigned i;
+
+	if (eepromLoadTopology(&count, &base) < 0)
+	{
+		return false;
+	}
+
+	// Addresses are handed out from BASE_ASSIGN_ADDR only
+	if ((base != BASE_ASSIGN_ADDR) || (count == 0) || (count > MAX_MODULES))
+	{
+		return false;
+	}
+
+	enumPolls = 0;
+
+	// Initalize I2C as master
+	Wire.begin(I2C_MASTER_ADDR);
+
+	// Keep the token with us
+	digitalWrite(TOKEN_SEND_PIN, LOW);
+
+	for (i = 0; i < count; ++i)
+	{
+		if (!I2CAddrProbe(base + i))
+		{
+			Serial.println("Module " + String(i) + " of the stored chain is missing");
+
+			return false;
+		}
+	}
+
+	// Past the stored end only a module added still holding an address can
+	// answer. One reset to no address fails its probe above instead, and is
+	// addressed by the full enumeration that follows.
+	if (I2CAddrProbe(base + count))
+	{
+		Serial.println("Chain grew since the last boot");
+
+		return false;
+	}
+
+	btnNum = count;
+	assignAddr = base + count;
+
+	enumTimeUs = micros() - startUs;
+
+	I2CAddrAllocTables();
+
+	Serial.println("Reusing stored chain: " + String(btnNum) + " modules in " + String(enumTimeUs) + "us");
+
+	return true;
+}
+
 void initializeI2CAddrs()
 {
+	unsigned long startUs;
+	unsigned long settleUs = ENUM_POLL_MIN_US;
+
 	// Reset assignAddr
 	assignAddr = BASE_ASSIGN_ADDR;
 
 	// Reset buttons number
 	btnNum = 0;
+	enumPolls = 0;
 
 	Serial.println("Initiating address distribution...");
 
 	// Initalize I2C as master
 	Wire.begin(I2C_MASTER_ADDR);
 
-	Serial.println("Setting TOKEN_SEND to LOW");
-
 	// Reset send pin
 	digitalWrite(TOKEN_SEND_PIN, LOW);
 
-	Serial.println("Waiting for TOKEN_RECV to be LOW...");
-
 	// Wait for the last chip to initialize... (Assume LOW requirement)
 	while (digitalRead(TOKEN_RECV_PIN) == HIGH)
 		;
 
-	Serial.println("Done. Kicking first chain member...");
 #ifdef REQUESTS
 	// Prepare request
 	Wire.onRequest(I2CAddrAsignReq);
 #endif
+	startUs = micros();
+
 	// Signal to the first chip it is its time for address allocation
 	digitalWrite(TOKEN_SEND_PIN, HIGH);
 
-	unsigned retries = 0;
-
 	// While last chip did not return the token,
 	// distribute addresses
 	while (1)
 	{
-		Serial.println("Assigning address: " + String(assignAddr) + "...");
+		unsigned long sentUs;
+		unsigned long pollUs = settleUs;
+		bool acked = false;
+
+		I2CAddrBroadcast();
+		sentUs = micros();
+
+		while (1)
+		{
+			delayMicroseconds(pollUs);
+
+			if (I2CAddrAcked())
+			{
+				acked = true;
+
+				break;
+			}
+
+			// Token came back around - Nobody left to take this address
+			if (digitalRead(TOKEN_RECV_PIN) == HIGH)
+			{
+				break;
+			}
+
+			// In case something in the return path failed for some reason.
+			// The first module may still be booting, so wait for it.
+			if ((micros() - sentUs > ENUM_MODULE_TIMEOUT_MS * 1000UL) && (assignAddr != BASE_ASSIGN_ADDR))
+			{
+				Serial.println("No response from address " + String(assignAddr));
+
+				break;
+			}
+
+			if (pollUs < ENUM_POLL_MAX_US)
+			{
+				pollUs = min(pollUs * 2, (unsigned long)ENUM_POLL_MAX_US);
+			}
+			else
+			{
+				// Slow to answer, maybe it missed the broadcast
+				I2CAddrBroadcast();
+			}
+		}
+
+		if (!acked)
+		{
+			break;
+		}
+
+		// Start polling the next module a bit before this one answered
+		settleUs = constrain((micros() - sentUs) / 2, (unsigned long)ENUM_POLL_MIN_US, (unsigned long)ENUM_POLL_MAX_US);
+
+		// Increase number of buttons
+		btnNum++;
+
+		// Increase addr assign
+		assignAddr += 1;
+
+		// No address left for modules further down the chain
+		if (btnNum == MAX_MODULES)
+		{
+			Serial.println("Chain is longer than " + String(MAX_MODULES) + " modules, the rest is left out");
+
+			break;
+		}
+	}
+
+	// Finish setup, drive token LOW
+	digitalWrite(TOKEN_SEND_PIN, LOW);
+
+	enumTimeUs = micros() - startUs;
+
+	I2CAddrAllocTables();
+
+	// Next boot can skip all this if the chain stays the same
+	eepromStoreTopology(btnNum, BASE_ASSIGN_ADDR);
+
+	Serial.println("Address distribution done: " + String(btnNum) + " modules in " + String(enumTimeUs) + "us");
+}
+
+bool requested[MAX_ADDR_ASSIGN_RETRIES];
+
+void setup()
+{
+	// Initialize EEPROM
+	EEPROM.begin();
+	eepromLoadWear();
+	eepromFindConfig();
+
+	// Initialize serial
+	Serial.begin(115200);
+
+	// Initialize init boolean
+	initDone = false;
+
+	// Reset token counters
+	tokenRecvCnt = 0;
+	tokenSentCnt = 0;
+
+	Serial.println("Board booted.");
+
+	// Setup token pins
+	pinMode(TOKEN_SEND_PIN, OUTPUT);
+	pinMode(TOKEN_RECV_PIN, INPUT); // INPUT_PULLUP ?
+	// attachInterrupt(digitalPinToInterrupt(TOKEN_RECV_PIN), tokenRecv, RISING);
+
+	// Assign all addresses - Unless the chain is still the one from last time
+	if (!restoreI2CAddrs())
+	{
+		initializeI2CAddrs();
+	}
+
+	// Load config - Only now I know how many buttons there are
+	if ((eepromHasConfig()) && (configStartup() < 0))
+	{
+		Serial.println("Error loading config. Is it initialized?");
+	}
+
+	// Start questioning all the modules
+	Wire.onReceive(dataHandler);
+
+	ledStrip->ClearTo(RgbColor(0, 0, 255));
+	ledStrip->Show();
+
+	// Initialize keyboard - Also links in its HID report descriptor
+	Keyboard.begin(KEYBOARD_LAYOUT);
+
+	for (int i = 0; i < MAX_ADDR_ASSIGN_RETRIES; ++i)
+	{
+		requested[i] = false;
+	}
+
+	// Now act as slave
+	Wire.begin(I2C_BCAST_ADDR);
+}
+
+// Color wheel: red -> blue -> green -> red, in 256 steps
+static const uint8_t wheelTable[256][3] PROGMEM = {
+	{ 255,   0,   0 }, { 252,   0,   3 }, { 249,   0,   6 }, { 246,   0,   9 },
+	{ 243,   0,  12 }, { 240,   0,  15 }, { 237,   0,  18 }, { 234,   0,  21 },
+	{ 231,   0,  24 }, { 228,   0,  27 }, { 225,   0,  30 }, { 222,   0,  33 },
+	{ 219,   0,  36 }, { 216,   0,  39 }, { 213,   0,  42 }, { 210,   0,  45 },
+	{ 207,   0,  48 }, { 204,   0,  51 }, { 201,   0,  54 }, { 198,   0,  57 },
+	{ 195,   0,  60 }, { 192,   0,  63 }, { 189,   0,  66 }, { 186,   0,  69 },
+	{ 183,   0,  72 }, { 180,   0,  75 }, { 177,   0,  78 }, { 174,   0,  81 },
+	{ 171,   0,  84 }, { 168,   0,  87 }, { 165,   0,  90 }, { 162,   0,  93 },
+	{ 159,   0,  96 }, { 156,   0,  99 }, { 153,   0, 102 }, { 150,   0, 105 },
+	{ 147,   0, 108 }, { 144,   0, 111 }, { 141,   0, 114 }, { 138,   0, 117 },
+	{ 135,   0, 120 }, { 132,   0, 123 }, { 129,   0, 126 }, { 126,   0, 129 },
+	{ 123,   0, 132 }, { 120,   0, 135 }, { 117,   0, 138 }, { 114,   0, 141 },
+	{ 111,   0, 144 }, { 108,   0, 147 }, { 105,   0, 150 }, { 102,   0, 153 },
+	{  99,   0, 156 }, {  96,   0, 159 }, {  93,   0, 162 }, {  90,   0, 165 },
+	{  87,   0, 168 }, {  84,   0, 171 }, {  81,   0, 174 }, {  78,   0, 177 },
+	{  75,   0, 180 }, {  72,   0, 183 }, {  69,   0, 186 }, {  66,   0, 189 },
+	{  63,   0, 192 }, {  60,   0, 195 }, {  57,   0, 198 }, {  54,   0, 201 },
+	{  51,   0, 204 }, {  48,   0, 207 }, {  45,   0, 210 }, {  42,   0, 213 },
+	{  39,   0, 216 }, {  36,   0, 219 }, {  33,   0, 222 }, {  30,   0, 225 },
+	{  27,   0, 228 }, {  24,   0, 231 }, {  21,   0, 234 }, {  18,   0, 237 },
+	{  15,   0, 240 }, {  12,   0, 243 }, {   9,   0, 246 }, {   6,   0, 249 },
+	{   3,   0, 252 }, {   0,   0, 255 }, {   0,   3, 252 }, {   0,   6, 249 },
+	{   0,   9, 246 }, {   0,  12, 243 }, {   0,  15, 240 }, {   0,  18, 237 },
+	{   0,  21, 234 }, {   0,  24, 231 }, {   0,  27, 228 }, {   0,  30, 225 },
+	{   0,  33, 222 }, {   0,  36, 219 }, {   0,  39, 216 }, {   0,  42, 213 },
+	{   0,  45, 210 }, {   0,  48, 207 }, {   0,  51, 204 }, {   0,  54, 201 },
+	{   0,  57, 198 }, {   0,  60, 195 }, {   0,  63, 192 }, {   0,  66, 189 },
+	{   0,  69, 186 }, {   0,  72, 183 }, {   0,  75, 180 }, {   0,  78, 177 },
+	{   0,  81, 174 }, {   0,  84, 171 }, {   0,  87, 168 }, {   0,  90, 165 },
+	{   0,  93, 162 }, {   0,  96, 159 }, {   0,  99, 156 }, {   0, 102, 153 },
+	{   0, 105, 150 }, {   0, 108, 147 }, {   0, 111, 144 }, {   0, 114, 141 },
+	{   0, 117, 138 }, {   0, 120, 135 }, {   0, 123, 132 }, {   0, 126, 129 },
+	{   0, 129, 126 }, {   0, 132, 123 }, {   0, 135, 120 }, {   0, 138, 117 },
+	{   0, 141, 114 }, {   0, 144, 111 }, {   0, 147, 108 }, {   0, 150, 105 },
+	{   0, 153, 102 }, {   0, 156,  99 }, {   0, 159,  96 }, {   0, 162,  93 },
+	{   0, 165,  90 }, {   0, 168,  87 }, {   0, 171,  84 }, {   0, 174,  81 },
+	{   0, 177,  78 }, {   0, 180,  75 }, {   0, 183,  72 }, {   0, 186,  69 },
+	{   0, 189,  66 }, {   0, 192,  63 }, {   0, 195,  60 }, {   0, 198,  57 },
+	{   0, 201,  54 }, {   0, 204,  51 }, {   0, 207,  48 }, {   0, 210,  45 },
+	{   0, 213,  42 }, {   0, 216,  39 }, {   0, 219,  36 }, {   0, 222,  33 },
+	{   0, 225,  30 }, {   0, 228,  27 }, {   0, 231,  24 }, {   0, 234,  21 },
+	{   0, 237,  18 }, {   0, 240,  15 }, {   0, 243,  12 }, {   0, 246,   9 },
+	{   0, 249,   6 }, {   0, 252,   3 }, {   0, 255,   0 }, {   3, 252,   0 },
+	{   6, 249,   0 }, {   9, 246,   0 }, {  12, 243,   0 }, {  15, 240,   0 },
+	{  18, 237,   0 }, {  21, 234,   0 }, {  24, 231,   0 }, {  27, 228,   0 },
+	{  30, 225,   0 }, {  33, 222,   0 }, {  36, 219,   0 }, {  39, 216,   0 },
+	{  42, 213,   0 }, {  45, 210,   0 }, {  48, 207,   0 }, {  51, 204,   0 },
+	{  54, 201,   0 }, {  57, 198,   0 }, {  60, 195,   0 }, {  63, 192,   0 },
+	{  66, 189,   0 }, {  69, 186,   0 }, {  72, 183,   0 }, {  75, 180,   0 },
+	{  78, 177,   0 }, {  81, 174,   0 }, {  84, 171,   0 }, {  87, 168,   0 },
+	{  90, 165,   0 }, {  93, 162,   0 }, {  96, 159,   0 }, {  99, 156,   0 },
+	{ 102, 153,   0 }, { 105, 150,   0 }, { 108, 147,   0 }, { 111, 144,   0 },
+	{ 114, 141,   0 }, { 117, 138,   0 }, { 120, 135,   0 }, { 123, 132,   0 },
+	{ 126, 129,   0 }, { 129, 126,   0 }, { 132, 123,   0 }, { 135, 120,   0 },
+	{ 138, 117,   0 }, { 141, 114,   0 }, { 144, 111,   0 }, { 147, 108,   0 },
+	{ 150, 105,   0 }, { 153, 102,   0 }, { 156,  99,   0 }, { 159,  96,   0 },
+	{ 162,  93,   0 }, { 165,  90,   0 }, { 168,  87,   0 }, { 171,  84,   0 },
+	{ 174,  81,   0 }, { 177,  78,   0 }, { 180,  75,   0 }, { 183,  72,   0 },
+	{ 186,  69,   0 }, { 189,  66,   0 }, { 192,  63,   0 }, { 195,  60,   0 },
+	{ 198,  57,   0 }, { 201,  54,   0 }, { 204,  51,   0 }, { 207,  48,   0 },
+	{ 210,  45,   0 }, { 213,  42,   0 }, { 216,  39,   0 }, { 219,  36,   0 },
+	{ 222,  33,   0 }, { 225,  30,   0 }, { 228,  27,   0 }, { 231,  24,   0 },
+	{ 234,  21,   0 }, { 237,  18,   0 }, { 240,  15,   0 }, { 243,  12,   0 },
+	{ 246,   9,   0 }, { 249,   6,   0 }, { 252,   3,   0 }, { 255,   0,   0 },
+};
+
+// Pulse brightness: a triangle over 256 steps, never below 20 - It flickers
+static const uint8_t pulseTable[256] PROGMEM = {
+	 20,  20,  20,  20,  20,  20,  20,  20,  20,  20,  20,  22,  24,  26,  28,  30,
+	 32,  34,  36,  38,  40,  42,  44,  46,  48,  50,  52,  54,  56,  58,  60,  62,
+	 64,  66,  68,  70,  72,  74,  76,  78,  80,  82,  84,  86,  88,  90,  92,  94,
+	 96,  98, 100, 102, 104, 106, 108, 110, 112, 114, 116, 118, 120, 122, 124, 126,
+	128, 130, 132, 134, 136, 138, 140, 142, 144, 146, 148, 150, 152, 154, 156, 158,
+	160, 162, 164, 166, 168, 170, 172, 174, 176, 178, 180, 182, 184, 186, 188, 190,
+	192, 194, 196, 198, 200, 202, 204, 206, 208, 210, 212, 214, 216, 218, 220, 222,
+	224, 226, 228, 230, 232, 234, 236, 238, 240, 242, 244, 246, 248, 250, 252, 254,
+	255, 253, 251, 249, 247, 245, 243, 241, 239, 237, 235, 233, 231, 229, 227, 225,
+	223, 221, 219, 217, 215, 213, 211, 209, 207, 205, 203, 201, 199, 197, 195, 193,
+	191, 189, 187, 185, 183, 181, 179, 177, 175, 173, 171, 169, 167, 165, 163, 161,
+	159, 157, 155, 153, 151, 149, 147, 145, 143, 141, 139, 137, 135, 133, 131, 129,
+	127, 125, 123, 121, 119, 117, 115, 113, 111, 109, 107, 105, 103, 101,  99,  97,
+	 95,  93,  91,  89,  87,  85,  83,  81,  79,  77,  75,  73,  71,  69,  67,  65,
+	 63,  61,  59,  57,  55,  53,  51,  49,  47,  45,  43,  41,  39,  37,  35,  33,
+	 31,  29,  27,  25,  23,  21,  20,  20,  20,  20,  20,  20,  20,  20,  20,  20,
+};
+
+static RgbColor Gradient(uint8_t btnIdx)
+{
+	uint8_t pos = 255 - (btnRuntime[btnIdx].phase + (animationPhase >> 8));
+
+	return RgbColor(pgm_read_byte(&wheelTable[pos][0]), pgm_read_byte(&wheelTable[pos][1]), pgm_read_byte(&wheelTable[pos][2]));
+}
+
+// c * level / 255, within 1
+static uint8_t scale8(uint8_t c, uint8_t level)
+{
+	return ((uint16_t)c * (level + 1)) >> 8;
+}
+
+static RgbColor Pulse(const struct led_obj_s* color)
+{
+	return RgbColor(scale8(color->ledR, animationPulseLevel), scale8(color->ledG, animationPulseLevel), scale8(color->ledB, animationPulseLevel));
+}
+
+static RgbColor Still(const struct led_obj_s* color)
+{
+	return RgbColor(color->ledR, color->ledG, color->ledB);
+}
+
+static void animationClassesRender()
+{
+	uint8_t i;
+
+	for (i = 0; i < animClassNum; ++i)
+	{
+		struct animation_class_s* cls = &animClasses[i];
+
+		cls->frame = (cls->type == ANIMATION_PULSE) ? Pulse(&cls->color) : Still(&cls->color);
+	}
+}
+
+// Only store colors that differ, so IsDirty() tells whether a frame changed
+static void ledSetPixel(uint8_t btnIdx, RgbColor color)
+{
+	if (ledStrip->GetPixelColor(btnIdx) != color)
+	{
+		ledStrip->SetPixelColor(btnIdx, color);
+	}
+}
+
+static RgbColor ledColor(uint8_t btnIdx)
+{
+	struct led_obj_s color;
+
+	if (btnRuntime[btnIdx].state == BTN_STATE_PRESSED)
+	{
+		if (isConfigured())
+		{
+			// Override during configuration phase
+			if (sendBtnPressesOverSerial)
+			{
+				return RgbColor(0, 0, 255);
+			}
+
+			if (btnClickColor(btnIdx, &color))
+			{
+				return RgbColor(color.ledR, color.ledG, color.ledB);
+			}
+		}
+
+		return RgbColor(0, 255, 0);
+	}
 
-		ledStrip.SetPixelColor((assignAddr - BASE_ASSIGN_ADDR), RgbColor(0, 0, 255));
-		ledStrip.Show();
+	if (isConfigured())
+	{
+		// Override during configuration phase
+		if (sendBtnPressesOverSerial)
+		{
+			return RgbColor(255, 255, 255);
+		}
 
-#ifdef REQUESTS
-		// Wait for message from this address
-		Wire.beginTransmission(I2C_BCAST_ADDR);
-		Wire.write(assignAddr);
-		Wire.endTransmission();
-		Wire.requestFrom(assignAddr, (uint8_t)1);
-#else
-		Wire.beginTransmission(I2C_BCAST_ADDR);
-		Wire.write(assignAddr);
-		Wire.endTransmission();
-#endif
-		// Wait for 100ms
-		delay(100);
+		if (btnRuntime[btnIdx].animClass != ANIMATION_CLASS_NONE)
+		{
+			return animClasses[btnRuntime[btnIdx].animClass].frame;
+		}
 
-		if (!Wire.available())
+		switch (btnAnimation(btnIdx, &color))
 		{
-			// In case something in the return path failed for some reason
-			if ((++retries > MAX_ADDR_ASSIGN_RETRIES) && (assignAddr != BASE_ASSIGN_ADDR))
+			case ANIMATION_GRADIENT:
 			{
-				break;
+				return Gradient(btnIdx);
 			}
 
-			Serial.println("Did not receive response. Retrying (" + String(retries) + ")...");
-		}
-		else
-		{
-			uint8_t ack = Wire.read();
+			case ANIMATION_PULSE:
+			{
+				return Pulse(&color);
+			}
 
-			// Demand the ack to be the same address assigned
-			if (ack == assignAddr)
+			case ANIMATION_STILL:
 			{
-				Serial.println("Received ACK from " + String(ack));
+				return Still(&color);
+			}
 
-				btnStates = (enum btn_state_e*)realloc(btnStates, sizeof(enum btn_state_e) * (assignAddr + 1));
-				keyMap = (struct key_obj_s**)realloc(keyMap, sizeof(struct key_obj_s*) * (btnNum + 1));
-				ledsMap = (struct led_obj_s**)realloc(ledsMap, sizeof(struct led_obj_s*) * (btnNum + 1));
-				animationMap = (struct animation_obj_s**)realloc(animationMap, sizeof(struct animation_obj_s*) * (btnNum + 1));
+			default:
+			{
+				break;
+			}
+		}
+	}
 
-				// Reset this new cell
-				keyMap[btnNum] = NULL;
-				ledsMap[btnNum] = NULL;
-				animationMap[btnNum] = NULL;
+	return RgbColor(255, 0, 0);
+}
 
-				// Increase number of buttons
-				btnNum++;
+static void renderLeds()
+{
+	static unsigned long prevFrameMillis = 0;
+	unsigned long now = millis();
+	unsigned i;
 
-				btnStates[assignAddr] = BTN_STATE_RELEASED;
+#ifdef CONFIG_XIP
+	// Colors are read from EEPROM - Don't wait out a byte write for a frame
+	if (!eeprom_is_ready())
+	{
+		return;
+	}
+#endif
 
-				ledStrip.SetPixelColor((assignAddr - BASE_ASSIGN_ADDR), RgbColor(0, 255, 0));
-				ledStrip.Show();
+	// Compute a new frame at most LED_TARGET_FPS times a second
+	if (now - prevFrameMillis >= LED_FRAME_MS)
+	{
+		prevFrameMillis = now;
 
-				// Increase addr assign
-				assignAddr += 1;
+		// Animation phase follows time, not the number of loop() passes
+		animationPhase = now * ANIMATION_PHASE_PER_MS;
+		animationPulsePhase = now * ANIMATION_PULSE_PHASE_PER_MS;
+		animationPulseLevel = pgm_read_byte(&pulseTable[animationPulsePhase >> 8]);
 
-				retries = 0;
+		animationClassesRender();
 
-				// Finish it up
-				if (digitalRead(TOKEN_RECV_PIN) == HIGH)
-				{
-					break;
-				}
-			}
-			else
-			{
-				Serial.println("Received something: " + String(ack));
-			}
+		for (i = 0; i < btnNum; i++)
+		{
+			ledSetPixel(i, ledColor(i));
 		}
 	}
+}
 
-	// Finish setup, drive token LOW
-	digitalWrite(TOKEN_SEND_PIN, LOW);
+static void showLeds()
+{
+	// Send only changed frames, and never stall the scan waiting for the latch
+	if ((ledStrip->IsDirty()) && (ledStrip->CanShow()))
+	{
+		ledStrip->Show();
 
-	Serial.println("Address distribution done.");
+		LOOP_STATS_SHOW();
+	}
 }
 
-bool requested[MAX_ADDR_ASSIGN_RETRIES];
+// ***** HID REPORT ACCUMULATOR *****
+// Key changes from a whole scan are collected into one report, which is sent
+// at most once per USB frame and only when it differs from what the host has.
+// Keyboard.press()/release() would send a report per call instead.
+#define HID_KEYBOARD_REPORT_ID 2
+#define HID_REPORT_KEYS 6
+#define USB_FRAME_US 1000
 
-void setup()
-{
-	// Initialize EEPROM
-	EEPROM.begin();
+// PluggableUSB hands out endpoints after CDC's, and HID is the only module
+#define HID_ENDPOINT (CDC_FIRST_ENDPOINT + CDC_ENPOINT_COUNT)
 
-	// Initialize serial
-	Serial.begin(115200);
+// Key encoding of Keyboard_::press(), printing keys are looked up in
+// KEYBOARD_LAYOUT as KeyboardLayout.h describes
+#define HID_KEY_NON_PRINTING 136
+#define HID_KEY_MODIFIER 128
 
-	// Initialize init boolean
-	initDone = false;
+static KeyReport hidReport;
+static KeyReport hidSentReport;
+static unsigned long hidLastSendUs = 0;
 
-	// Reset token counters
-	tokenRecvCnt = 0;
-	tokenSentCnt = 0;
+// Pressed and released before the press reached the host: released after the next send
+static uint8_t hidDeferredMods = 0;
+static uint8_t hidDeferredKeys[HID_REPORT_KEYS];
 
-	Serial.println("Board booted.");
+// Oldest button edge not yet reflected in a sent report
+static bool hidEdgePending = false;
+static unsigned long hidEdgeTimestamp = 0;
 
-	// Setup token pins
-	pinMode(TOKEN_SEND_PIN, OUTPUT);
-	pinMode(TOKEN_RECV_PIN, INPUT); // INPUT_PULLUP ?
-	// attachInterrupt(digitalPinToInterrupt(TOKEN_RECV_PIN), tokenRecv, RISING);
+// Translate a Keyboard key value to a usage code and modifier bits
+static uint8_t hidKeyUsage(uint8_t k, uint8_t* mods)
+{
+	*mods = 0;
 
-	// Reset LEDs
-	for (int i = 0; i < MAX_KEY_COUNT; ++i)
+	// Non-printing key
+	if (k >= HID_KEY_NON_PRINTING)
 	{
-		ledStrip.SetPixelColor(i, RgbColor(0, 0, 0));
+		return k - HID_KEY_NON_PRINTING;
 	}
 
-	ledStrip.Show();
+	// Modifier key
+	if (k >= HID_KEY_MODIFIER)
+	{
+		*mods = 1 << (k - HID_KEY_MODIFIER);
+
+		return 0;
+	}
 
-	// Assign all addresses
-	initializeI2CAddrs();
+	// Printing key
+	k = pgm_read_byte(KEYBOARD_LAYOUT + k);
 
-	// Load config - Only now I know how many buttons there are
-	if ((isConfigured()) && (configStartup() < 0))
+	if ((k & ALT_GR) == ALT_GR)
 	{
-		Serial.println("Error loading config. Is it initialized?");
+		// AltGr = right Alt
+		*mods = 0x40;
+		k &= 0x3F;
+	}
+	else if ((k & SHIFT) == SHIFT)
+	{
+		// The left shift modifier
+		*mods = 0x02;
+		k &= 0x7F;
 	}
 
-	// Start questioning all the modules
-	Wire.onReceive(dataHandler);
-
-	for (int i = 0; i < MAX_KEY_COUNT; ++i)
+	if (k == ISO_REPLACEMENT)
 	{
-		ledStrip.SetPixelColor(i, RgbColor(0, 0, 255));
+		k = ISO_KEY;
 	}
 
-	ledStrip.Show();
+	return k;
+}
 
-	// Initialize keyboard
-	// Keyboard.begin();
+static bool hidHasKey(const uint8_t* keys, uint8_t usage)
+{
+	unsigned i;
 
-	for (int i = 0; i < MAX_ADDR_ASSIGN_RETRIES; ++i)
+	for (i = 0; i < HID_REPORT_KEYS; ++i)
 	{
-		requested[i] = false;
+		if (keys[i] == usage)
+		{
+			return true;
+		}
 	}
 
-	// Now act as slave
-	Wire.begin(I2C_BCAST_ADDR);
+	return false;
 }
 
-static RgbColor Gradient(uint8_t btnIdx)
+static void hidRemoveKey(uint8_t* keys, uint8_t usage)
 {
-	uint8_t WheelPos = 255 - (((btnIdx * 256 / btnNum) + (animationCycle >> 2)) & 0xFF);
+	unsigned i;
 
-	if (WheelPos < 85)
+	for (i = 0; i < HID_REPORT_KEYS; ++i)
 	{
-		return RgbColor(255 - WheelPos * 3, 0, WheelPos * 3);
+		if (keys[i] == usage)
+		{
+			keys[i] = 0;
+		}
 	}
-	else if (WheelPos < 170)
+}
+
+static void hidPress(uint8_t k)
+{
+	uint8_t mods;
+	uint8_t usage = hidKeyUsage(k, &mods);
+	unsigned i;
+
+	hidReport.modifiers |= mods;
+
+	// Pressed again, cancel a pending release
+	hidDeferredMods &= ~mods;
+
+	if (usage == 0)
 	{
-		WheelPos -= 85;
-		return RgbColor(0, WheelPos * 3, 255 - WheelPos * 3);
+		return;
 	}
-	else
+
+	hidRemoveKey(hidDeferredKeys, usage);
+
+	if (hidHasKey(hidReport.keys, usage))
+	{
+		return;
+	}
+
+	// Take an empty slot, if any
+	for (i = 0; i < HID_REPORT_KEYS; ++i)
 	{
-		WheelPos -= 170;
-		return RgbColor(WheelPos * 3, 255 - WheelPos * 3, 0);
+		if (hidReport.keys[i] == 0)
+		{
+			hidReport.keys[i] = usage;
+
+			break;
+		}
 	}
 }
 
-static RgbColor Pulse(uint8_t btnIdx)
+static void hidRelease(uint8_t k)
 {
-	uint8_t cycle;
-	uint16_t animationCycleLocal = (animationCycle >> 2);
+	uint8_t mods;
+	uint8_t usage = hidKeyUsage(k, &mods);
+	uint8_t unsentMods = mods & ~hidSentReport.modifiers & hidReport.modifiers;
+	unsigned i;
+
+	// The host never saw these go down, keep them for one report
+	hidDeferredMods |= unsentMods;
+	hidReport.modifiers &= ~(mods & ~unsentMods);
 
-	if ((animationCycleLocal % 512) < 256)
+	if (usage == 0)
 	{
-		cycle = animationCycleLocal & 0xff;
+		return;
 	}
-	else
+
+	if ((hidHasKey(hidReport.keys, usage)) && (!hidHasKey(hidSentReport.keys, usage)))
+	{
+		if (!hidHasKey(hidDeferredKeys, usage))
+		{
+			for (i = 0; i < HID_REPORT_KEYS; ++i)
+			{
+				if (hidDeferredKeys[i] == 0)
+				{
+					hidDeferredKeys[i] = usage;
+
+					break;
+				}
+			}
+		}
+
+		return;
+	}
+
+	hidRemoveKey(hidReport.keys, usage);
+}
+
+// Send the accumulated report, at most once per USB frame
+static void hidFlush()
+{
+	unsigned long now = micros();
+	unsigned i;
+
+	if (memcmp(&hidReport, &hidSentReport, sizeof(KeyReport)) == 0)
+	{
+		return;
+	}
+
+	if (now - hidLastSendUs < USB_FRAME_US)
 	{
-		cycle = 255 - (animationCycleLocal & 0xff);
+		return;
 	}
 
-	// Never go 0. This flickers...
-	if (cycle < 20)
+	// USB not configured (yet), retry next frame
+	if (HID().SendReport(HID_KEYBOARD_REPORT_ID, &hidReport, sizeof(KeyReport)) < 0)
 	{
-		cycle = 20;
+		return;
 	}
 
-	uint32_t r = animationMap[btnIdx]->color.ledR;
-	uint32_t g = animationMap[btnIdx]->color.ledG;
-	uint32_t b = animationMap[btnIdx]->color.ledB;
+	hidLastSendUs = now;
+	memcpy(&hidSentReport, &hidReport, sizeof(KeyReport));
 
-	r *= cycle;
-	g *= cycle;
-	b *= cycle;
+	if (hidEdgePending)
+	{
+		unsigned long latency = micros() - hidEdgeTimestamp;
 
-	r /= 255;
-	g /= 255;
-	b /= 255;
+		if (latency > btnEventsMaxLatency)
+		{
+			btnEventsMaxLatency = latency;
+		}
 
-	return RgbColor(r, g, b);
-}
+		hidEdgePending = false;
+	}
 
-static RgbColor Still(uint8_t btnIdx)
-{
-	return RgbColor(animationMap[btnIdx]->color.ledR, animationMap[btnIdx]->color.ledG, animationMap[btnIdx]->color.ledB);
+	// Taps went down with this report, let them up with the next one
+	hidReport.modifiers &= ~hidDeferredMods;
+	hidDeferredMods = 0;
+
+	for (i = 0; i < HID_REPORT_KEYS; ++i)
+	{
+		if (hidDeferredKeys[i])
+		{
+			hidRemoveKey(hidReport.keys, hidDeferredKeys[i]);
+			hidDeferredKeys[i] = 0;
+		}
+	}
 }
 
-void loop()
+static void btnKeysPress(uint8_t btnIdx, unsigned long now)
 {
-	unsigned i = 0;
-	static unsigned long prevReconfigMillis = 0;
+	uint8_t keyCount = btnKeyCount(btnIdx);
+	struct key_cfg_s key;
+	bool repeats = false;
+	unsigned i;
 
-	for (i = BASE_ASSIGN_ADDR; i < assignAddr; i++)
+	// Press all buttons
+	for (i = 0; i < keyCount; ++i)
 	{
-		uint8_t btnIdx = i - BASE_ASSIGN_ADDR;
+		btnKey(btnIdx, i, &key);
+		hidPress(key.keyValue);
 
-		if (btnStates[i] == BTN_STATE_PRESSED)
+		// Continuous keys are tapped, then again on every repeat. The others
+		// stay down until the button is released.
+		if (key.pressType == BTN_PRESS_TYPE_CONT)
 		{
-			if (isConfigured())
-			{
-				// Override during configuration phase
-				if (sendBtnPressesOverSerial)
-				{
-					ledStrip.SetPixelColor(btnIdx, RgbColor(0, 0, 255));
+			hidRelease(key.keyValue);
 
-					continue;
-				}
+			repeats = true;
+		}
+	}
 
-				led_obj_s* color = ledsMap[btnIdx];
+	// With every slot taken the button just doesn't repeat
+	if ((repeats) && (keyRepeatNum < KEY_REPEAT_SLOTS))
+	{
+		keyRepeats[keyRepeatNum].btnIdx = btnIdx;
 
-				if (color)
-				{
-					ledStrip.SetPixelColor(btnIdx, RgbColor(color->ledR, color->ledG, color->ledB));
+		// First repeat is longer
+		keyRepeats[keyRepeatNum].at = now + KEY_REPEAT_DELAY_MS;
 
-					continue;
-				}
-			}
+		keyRepeatNum++;
+	}
+}
 
-			ledStrip.SetPixelColor(btnIdx, RgbColor(0, 255, 0));
-		}
-		else
-		{
-			if (isConfigured())
-			{
-				struct animation_obj_s* animation = animationMap[btnIdx];
+static void btnKeysRepeat(struct key_repeat_s* repeat, unsigned long now)
+{
+	uint8_t btnIdx = repeat->btnIdx;
+	uint8_t keyCount;
+	struct key_cfg_s key;
+	unsigned i;
 
-				// Override during configuration phase
-				if (sendBtnPressesOverSerial)
-				{
-					ledStrip.SetPixelColor(btnIdx, RgbColor(255, 255, 255));
+	if ((int16_t)((uint16_t)now - repeat->at) < 0)
+	{
+		return;
+	}
 
-					continue;
-				}
+	keyCount = btnKeyCount(btnIdx);
 
-				if (animation)
-				{
-					switch (animation->type)
-					{
-						case ANIMATION_GRADIENT:
-						{
-							ledStrip.SetPixelColor(btnIdx, Gradient(btnIdx));
-
-							continue;
-						}
-
-						case ANIMATION_PULSE:
-						{
-							ledStrip.SetPixelColor(btnIdx, Pulse(btnIdx));
-
-							continue;
-						}
-
-						case ANIMATION_STILL:
-						{
-							ledStrip.SetPixelColor(btnIdx, Still(btnIdx));
-							continue;
-						}
-
-						default:
-						{
-							break;
-						}
-					}
-				}
-			}
+	// Only continuous keys repeat
+	for (i = 0; i < keyCount; ++i)
+	{
+		btnKey(btnIdx, i, &key);
 
-			ledStrip.SetPixelColor(btnIdx, RgbColor(255, 0, 0));
+		if (key.pressType == BTN_PRESS_TYPE_CONT)
+		{
+			hidPress(key.keyValue);
+			hidRelease(key.keyValue);
 		}
 	}
 
-	animationCycle++;
+	// Subsequent are quicker
+	repeat->at = now + KEY_REPEAT_RATE_MS;
+}
 
-	ledStrip.Show();
+static void btnKeysRelease(uint8_t btnIdx)
+{
+	uint8_t keyCount = btnKeyCount(btnIdx);
+	struct key_cfg_s key;
+	unsigned i;
 
-	// Always try and update config
-	if (millis() - prevReconfigMillis >= 200)
+	for (i = 0; i < keyRepeatNum; ++i)
 	{
-		handleSerialConfig();
+		if (keyRepeats[i].btnIdx == btnIdx)
+		{
+			keyRepeats[i] = keyRepeats[--keyRepeatNum];
 
-		// Update millis
-		prevReconfigMillis = millis();
+			break;
+		}
 	}
 
-	// If init is not done, don't execute main logic yet
-	if (!isConfigured())
+	// Release all buttons
+	for (i = 0; i < keyCount; ++i)
 	{
-		return;
+		btnKey(btnIdx, i, &key);
+		hidRelease(key.keyValue);
 	}
+}
+
+static void handleBtnEvents()
+{
+	struct btn_event_s ev;
 
-	for (i = BASE_ASSIGN_ADDR; i < assignAddr; i++)
+	while (btnEventPop(&ev))
 	{
-		uint8_t btnIdx = i - BASE_ASSIGN_ADDR;
-		key_obj_s* obj = keyMap[btnIdx];
+		uint8_t btnIdx = ev.addr - BASE_ASSIGN_ADDR;
+
+		// From a chain refused for lack of RAM
+		if (btnIdx >= btnNum)
+		{
+			continue;
+		}
 
+		// Modules may repeat their current state
+		if (btnRuntime[btnIdx].state == ev.state)
+		{
+			continue;
+		}
+
+		btnRuntime[btnIdx].state = ev.state;
 
-		if (btnStates[i] == BTN_STATE_PRESSED)
+		if (!isConfigured())
 		{
-			unsigned long diff = millis() - obj->tick;
-			unsigned long now = millis();
+			continue;
+		}
 
+		if (ev.state == BTN_STATE_PRESSED)
+		{
 			// If app requests sending indexes - send instread of press
 			if (sendBtnPressesOverSerial)
 			{
@@ -983,73 +2987,91 @@ void loop()
 				continue;
 			}
 
-			// Press all buttons
-			while (obj)
-			{
-				// Serial.println(String(__LINE__) + " Button idx: " + String(btnIdx) + " Ptr: 0x" + String((unsigned int)obj, 16) + " Key value: " + String(obj->keyValue) + " Number of configs: " + String(config->configObjNum));
-				// Serial.println("Key value: " + String(config->objects[0].data.key.keyValue) + " Key object: " + String((unsigned int)&config->objects[0].data, 16));
+			btnKeysPress(btnIdx, millis());
+		}
+		else
+		{
+			btnKeysRelease(btnIdx);
+		}
 
-				// Only when cooldown is 0, press again
-				if (obj->press_type == BTN_PRESS_TYPE_ONCE)
-				{
-					if (obj->cooldown == 0)
-					{
-						Keyboard.press(obj->keyValue);
+		// Latency is taken when the report carrying this edge goes out
+		if ((!hidEdgePending) && (memcmp(&hidReport, &hidSentReport, sizeof(KeyReport)) != 0))
+		{
+			hidEdgePending = true;
+			hidEdgeTimestamp = ev.timestamp;
+		}
+	}
+}
 
-						// Don't press again
-						obj->cooldown = 1;
-					}
-				}
-				else
-				{
-					if (obj->cooldown <= 1)
-					{
-						Keyboard.press(obj->keyValue);
-						Keyboard.release(obj->keyValue);
-
-						// First press is longer
-						if (obj->cooldown == 0)
-						{
-							obj->cooldown = 300;
-						}
-						// Subsequent are quicker
-						else if (obj->cooldown == 1)
-						{
-							obj->cooldown = 30;
-						}
-					}
-					else
-					{
-						// Reset, prevent underflow
-						if (diff >= obj->cooldown)
-						{
-							obj->cooldown = 1;
-						}
-						else
-						{
-							obj->cooldown -= diff;
-						}
-					}
-				}
+// Between two windows of an LED frame: the edges the TWI ISR queued meanwhile
+// go out in a report now rather than after the frame. Anything that could
+// wait on the host or the EEPROM is left to loop(), so a gap stays at tens
+// of microseconds, well inside the strip's gap limit.
+static void ledShowGap(void* context)
+{
+	// A press may have to be echoed, and Serial.write() waits for room
+	if ((sendBtnPressesOverSerial) && (Serial.availableForWrite() < 1))
+	{
+		return;
+	}
+
+#ifdef CONFIG_XIP
+	// Keys are read from the EEPROM, which waits for a byte write to finish
+	if (!eeprom_is_ready())
+	{
+		return;
+	}
+#endif
 
-				obj->tick = now;
+	handleBtnEvents();
 
-				obj = obj->next;
-			}
-		}
-		else
-		{
-			// Release all buttons
-			while (obj)
-			{
+	// USB_Send() waits with delay(1) until the host took the last report
+	if ((isConfigured()) && (USB_SendSpace(HID_ENDPOINT) >= 1 + (int)sizeof(KeyReport)))
+	{
+		hidFlush();
+	}
+}
 
-				Keyboard.release(obj->keyValue);
+void loop()
+{
+	unsigned i = 0;
 
-				obj->cooldown = 0;
-				obj->tick = 0;
+	LOOP_STATS_BEGIN();
 
-				obj = obj->next;
-			}
-		}
+	renderLeds();
+	LOOP_STATS_STAGE(LOOP_STAGE_LED);
+
+	showLeds();
+	LOOP_STATS_STAGE(LOOP_STAGE_SHOW);
+
+	// Always try and update config
+	handleSerialConfig();
+	LOOP_STATS_STAGE(LOOP_STAGE_SERIAL);
+
+	// Finish pending EEPROM writes, a byte at a time
+	eepromWriterRun();
+	LOOP_STATS_STAGE(LOOP_STAGE_EEPROM);
+
+	// Act on every edge the ISR queued since the last pass
+	handleBtnEvents();
+
+	// If init is not done, don't execute main logic yet
+	if (!isConfigured())
+	{
+		LOOP_STATS_STAGE(LOOP_STAGE_KEYS);
+
+		return;
+	}
+
+	// Auto-repeat held buttons
+	for (i = 0; i < keyRepeatNum; i++)
+	{
+		btnKeysRepeat(&keyRepeats[i], millis());
 	}
+
+	LOOP_STATS_STAGE(LOOP_STAGE_KEYS);
+
+	// One report for everything that changed in this pass
+	hidFlush();
+	LOOP_STATS_STAGE(LOOP_STAGE_HID);
 }
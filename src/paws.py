@@ -290,6 +290,119 @@ def readNumberOfModules(s):
     return int(num[0])
 
 
+def readEventStats(s):
+    # Request button event queue statistics
+    s.write(bytes([0x45, 0x45]))
+
+    data = s.read(9)
+
+    eod = s.read(1)
+
+    if len(data) != 9 or eod != b"\xff":
+        print("Error recving event stats")
+
+        return None
+
+    overflows, invalid, maxDepth, maxLatencyUs = unpack("<HHBI", data)
+
+    return {
+        "overflows": overflows,
+        "invalid": invalid,
+        "maxDepth": maxDepth,
+        "maxLatencyUs": maxLatencyUs,
+    }
+
+
+def readEnumTime(s):
+    # Request module enumeration time
+    s.write(bytes([0x46, 0x46]))
+
+    data = s.read(6)
+
+    eod = s.read(1)
+
+    if len(data) != 6 or eod != b"\xff":
+        print("Error recving enumeration time")
+
+        return None
+
+    enumTimeUs, polls = unpack("<IH", data)
+
+    return {
+        "enumTimeUs": enumTimeUs,
+        "polls": polls,
+    }
+
+
+def readEepromWear(s):
+    # Request EEPROM byte writes per region
+    s.write(bytes([0x47, 0x47]))
+
+    regions = s.read(1)
+
+    if len(regions) != 1:
+        print("Error recving EEPROM wear")
+
+        return None
+
+    data = s.read(4 * regions[0])
+
+    eod = s.read(1)
+
+    if len(data) != 4 * regions[0] or eod != b"\xff":
+        print("Error recving EEPROM wear")
+
+        return None
+
+    return list(unpack("<%dI" % regions[0], data))
+
+
+LOOP_STAGES = ["led", "show", "serial", "eeprom", "keys", "hid"]
+LOOP_PERIOD_BINS = 8
+
+
+def readLoopStats(s):
+    # Request loop() stage timings - Not in release builds
+    s.write(bytes([0x48, 0x48]))
+
+    size = 4 + 4 + 2 + 4 * LOOP_PERIOD_BINS + 6 * len(LOOP_STAGES) + 2 + 2 + 2 + 2
+
+    data = s.read(size)
+
+    eod = s.read(1)
+
+    if len(data) != size or eod != b"\xff":
+        print("Error recving loop stats")
+
+        return None
+
+    loops, periodTotalUs, periodMaxUs = unpack("<IIH", data[:10])
+    bins = list(unpack("<%dI" % LOOP_PERIOD_BINS, data[10 : 10 + 4 * LOOP_PERIOD_BINS]))
+    data = data[10 + 4 * LOOP_PERIOD_BINS :]
+    stageTotalUs = unpack("<%dI" % len(LOOP_STAGES), data[: 4 * len(LOOP_STAGES)])
+    data = data[4 * len(LOOP_STAGES) :]
+    stageMaxUs = unpack("<%dH" % len(LOOP_STAGES), data[: 2 * len(LOOP_STAGES)])
+    shows, isrEntries, ledGapMaxUs, ledGapOverruns = unpack("<HHHH", data[2 * len(LOOP_STAGES) :])
+
+    return {
+        "loops": loops,
+        "periodAvgUs": periodTotalUs / loops if loops else 0,
+        "periodMaxUs": periodMaxUs,
+        "periodBins": bins,
+        "stages": {
+            name: {
+                "avgUs": stageTotalUs[i] / loops if loops else 0,
+                "maxUs": stageMaxUs[i],
+            }
+            for i, name in enumerate(LOOP_STAGES)
+        },
+        "shows": shows,
+        "isrEntries": isrEntries,
+        "ledGapMaxUs": ledGapMaxUs,
+        "ledGapOverruns": ledGapOverruns,
+    }
+
+
 def functions():
     s = probePort("COM22")
 